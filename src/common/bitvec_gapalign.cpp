@@ -0,0 +1,259 @@
+#include "bitvec_gapalign.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+#define HIGH_BIT (1ULL << 63)
+
+// advance one 64-row word of the edit distance matrix by one column,
+// hin is the horizontal delta entering at the top of the word,
+// the horizontal delta leaving at out_bit is returned.
+static inline int
+advance_word(const u8_t eq_in, u8_t& Pv, u8_t& Mv, const int hin, const u8_t out_bit)
+{
+	u8_t Eq = eq_in;
+	const u8_t Xv = Eq | Mv;
+	if (hin < 0) Eq |= 1;
+	const u8_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+	u8_t Ph = Mv | ~(Xh | Pv);
+	u8_t Mh = Pv & Xh;
+	int hout = 0;
+	if (Ph & out_bit) hout = 1;
+	else if (Mh & out_bit) hout = -1;
+	Ph <<= 1;
+	Mh <<= 1;
+	if (hin < 0) Mh |= 1;
+	else if (hin > 0) Ph |= 1;
+	Pv = Mh | ~(Xv | Ph);
+	Mv = Ph & Xv;
+	return hout;
+}
+
+static inline int
+popcount_prefix(const u8_t* v, const int i)
+{
+	int n = 0, w = 0;
+	for (; w < (i >> 6); ++w) n += __builtin_popcountll(v[w]);
+	if (i & 63) n += __builtin_popcountll(v[w] & ((1ULL << (i & 63)) - 1));
+	return n;
+}
+
+// D[i][j], the edit distance between the first i bases of the query block and the first j bases of the target block
+int
+BitVectorAligner::column_score(const int i, const int j) const
+{
+	const u8_t* P = pv + j * num_words;
+	const u8_t* M = mv + j * num_words;
+	return j + popcount_prefix(P, i) - popcount_prefix(M, i);
+}
+
+static inline int
+vertical_delta(const u8_t* P, const u8_t* M, const int i)
+{
+	if ((P[i >> 6] >> (i & 63)) & 1) return 1;
+	if ((M[i >> 6] >> (i & 63)) & 1) return -1;
+	return 0;
+}
+
+void
+BitVectorAligner::align_block(const char* Q, const int m, const char* T, const int n, const bool forward)
+{
+	align->init();
+	align->dist = 0;
+	if (m <= 0 || n <= 0) return;
+	r_assert(m <= param.max_block_size && n <= param.max_block_size);
+
+	num_words = (m + 63) >> 6;
+	const int W = num_words;
+	const u8_t last_bit = 1ULL << ((m - 1) & 63);
+	memset(peq, 0, sizeof(u8_t) * 4 * W);
+	for (int i = 0; i < m; ++i) {
+		const int c = extract_char<u1_t>(Q, i, forward) & 3;
+		peq[c * W + (i >> 6)] |= 1ULL << (i & 63);
+	}
+
+	// column 0: D[i][0] = i
+	for (int w = 0; w < W; ++w) {
+		pv[w] = ~0ULL;
+		mv[w] = 0;
+	}
+
+	// the end point is the cell of minimal distance on the last row or the last column
+	int best_score = m, best_i = m, best_j = 0;
+	int last_row_score = m;
+	for (int j = 1; j <= n; ++j) {
+		const int c = extract_char<u1_t>(T, j - 1, forward) & 3;
+		const u8_t* eq = peq + c * W;
+		const u8_t* P0 = pv + (j - 1) * W;
+		const u8_t* M0 = mv + (j - 1) * W;
+		u8_t* P = pv + j * W;
+		u8_t* M = mv + j * W;
+		int h = 1;
+		for (int w = 0; w < W; ++w) {
+			P[w] = P0[w];
+			M[w] = M0[w];
+			h = advance_word(eq[w], P[w], M[w], h, (w == W - 1) ? last_bit : HIGH_BIT);
+		}
+		last_row_score += h;
+		if (last_row_score < best_score || (last_row_score == best_score && j > best_j)) {
+			best_score = last_row_score;
+			best_i = m;
+			best_j = j;
+		}
+	}
+	{
+		const u8_t* P = pv + n * W;
+		const u8_t* M = mv + n * W;
+		int score = n;
+		for (int i = 1; i <= m; ++i) {
+			score += vertical_delta(P, M, i - 1);
+			if (score < best_score || (score == best_score && i + n > best_i + best_j)) {
+				best_score = score;
+				best_i = i;
+				best_j = n;
+			}
+		}
+	}
+
+	// trace back from the end point, the path is written backwards from the end of the buffers
+	char* qstr = align->q_aln_str;
+	char* tstr = align->t_aln_str;
+	const int cap = param.segment_aln_size;
+	int pos = cap;
+	int i = best_i, j = best_j;
+	int d = best_score;
+	while (i > 0 || j > 0) {
+		--pos;
+		if (i > 0 && j > 0) {
+			const int dleft = column_score(i, j - 1);
+			const int ddiag = dleft - vertical_delta(pv + (j - 1) * W, mv + (j - 1) * W, i - 1);
+			const int dup = d - vertical_delta(pv + j * W, mv + j * W, i - 1);
+			const char qc = extract_char<char>(Q, i - 1, forward);
+			const char tc = extract_char<char>(T, j - 1, forward);
+			if ((qc == tc && ddiag == d) || (qc != tc && ddiag + 1 == d)) {
+				qstr[pos] = qc;
+				tstr[pos] = tc;
+				--i; --j; d = ddiag;
+			} else if (dup + 1 == d) {
+				qstr[pos] = qc;
+				tstr[pos] = GAP_CODE;
+				--i; d = dup;
+			} else {
+				r_assert(dleft + 1 == d);
+				qstr[pos] = GAP_CODE;
+				tstr[pos] = tc;
+				--j; d = dleft;
+			}
+		} else if (i > 0) {
+			qstr[pos] = extract_char<char>(Q, i - 1, forward);
+			tstr[pos] = GAP_CODE;
+			--i; --d;
+		} else {
+			qstr[pos] = GAP_CODE;
+			tstr[pos] = extract_char<char>(T, j - 1, forward);
+			--j; --d;
+		}
+	}
+	const int aln_size = cap - pos;
+	memmove(qstr, qstr + pos, aln_size);
+	memmove(tstr, tstr + pos, aln_size);
+
+	// the distance is minimal up to the block boundary, which may lie beyond the
+	// true end of the overlap, so the path is cut where the +1/-1 score peaks
+	int score = 0, max_score = 0, max_k = 0, qcnt = 0, tcnt = 0, best_qcnt = 0, best_tcnt = 0, dist = 0, best_dist = 0;
+	for (int k = 0; k < aln_size; ++k) {
+		if (qstr[k] != GAP_CODE) ++qcnt;
+		if (tstr[k] != GAP_CODE) ++tcnt;
+		if (qstr[k] == tstr[k]) {
+			++score;
+		} else {
+			--score;
+			++dist;
+		}
+		if (score > max_score) {
+			max_score = score;
+			max_k = k + 1;
+			best_qcnt = qcnt;
+			best_tcnt = tcnt;
+			best_dist = dist;
+		}
+	}
+	align->aln_str_size = max_k;
+	align->aln_q_e = best_qcnt;
+	align->aln_t_e = best_tcnt;
+	align->dist = best_dist;
+}
+
+void
+BitVectorAligner::extend(const char* query, const int query_size, const char* target, const int target_size, const bool forward)
+{
+	const int kTailMatchBP = 4;
+	const int kBlkSize = param.segment_size;
+	int qidx = 0, tidx = 0;
+	int qblk, tblk;
+	const char* seq1;
+	const char* seq2;
+	while (1) {
+		bool last_block = retrieve_next_aln_block(query,
+												  qidx,
+												  query_size,
+												  target,
+												  tidx,
+												  target_size,
+												  kBlkSize,
+												  forward,
+												  seq1,
+												  seq2,
+												  qblk,
+												  tblk);
+		align_block(seq1, qblk, seq2, tblk, forward);
+
+		int qcnt = 0, tcnt = 0, acnt = 0;
+		const bool trim = trim_mismatch_end(align->q_aln_str,
+											align->t_aln_str,
+											align->aln_str_size,
+											kTailMatchBP,
+											qcnt,
+											tcnt,
+											acnt);
+		if (!trim) break;
+
+		bool full_map = false;
+		if (qblk - align->aln_q_e <= 20 || tblk - align->aln_t_e <= 20) full_map = true;
+
+		if (last_block || (!full_map)) {
+			qcnt -= kTailMatchBP;
+			tcnt -= kTailMatchBP;
+			acnt -= kTailMatchBP;
+		}
+		align->aln_str_size -= acnt;
+		if (forward) {
+			memcpy(result->right_store1 + result->right_store_size, align->q_aln_str, align->aln_str_size);
+			memcpy(result->right_store2 + result->right_store_size, align->t_aln_str, align->aln_str_size);
+			result->right_store_size += align->aln_str_size;
+		} else {
+			memcpy(result->left_store1 + result->left_store_size, align->q_aln_str, align->aln_str_size);
+			memcpy(result->left_store2 + result->left_store_size, align->t_aln_str, align->aln_str_size);
+			result->left_store_size += align->aln_str_size;
+		}
+
+		if (last_block || (!full_map)) break;
+		qidx += (align->aln_q_e - qcnt);
+		tidx += (align->aln_t_e - tcnt);
+	}
+}
+
+bool
+BitVectorAligner::go(const char* query, const int qstart, const int qsize,
+					 const char* target, const int tstart, const int tsize,
+					 const int min_aln_size)
+{
+	result->init();
+	extend(query + qstart - 1, qstart, target + tstart - 1, tstart, false);
+	extend(query + qstart, qsize - qstart, target + tstart, tsize - tstart, true);
+	build_output_store(result, qstart, tstart);
+
+	return result->out_store_size >= min_aln_size;
+}
@@ -0,0 +1,97 @@
+#ifndef BITVEC_GAPALIGN_H
+#define BITVEC_GAPALIGN_H
+
+#include "defs.h"
+#include "diff_gapalign.h"
+#include "gapalign.h"
+
+struct BitVectorAlignParameters
+{
+	int segment_size;
+	int max_block_size;
+	int max_words;
+	int segment_aln_size;
+	int max_aln_size;
+
+	void init(const int large_block = 0) {
+		segment_size = large_block ? 1000 : 500;
+		// retrieve_next_aln_block() lets the last block grow up to 20% over the other sequence
+		max_block_size = static_cast<int>((segment_size + 100) * 1.2) + 2;
+		max_words = (max_block_size + 63) / 64;
+		segment_aln_size = 2 * max_block_size;
+		max_aln_size = MAX_SEQ_SIZE;
+	}
+};
+
+// Gapped extension with Myers' bit-vector edit distance (Hyyro's multi-word
+// formulation), one 64-bit word per 64 query bases of a block. Extension is
+// done block by block as in DiffAligner, the vertical delta vectors of every
+// column are kept for the traceback.
+class BitVectorAligner : public GapAligner
+{
+public:
+	BitVectorAligner(const int large_block = 0) {
+		param.init(large_block);
+		align = new Alignment(param.segment_aln_size);
+		result = new OutputStore(param.max_aln_size);
+		snew(peq, u8_t, 4 * param.max_words);
+		snew(pv, u8_t, (param.max_block_size + 1) * param.max_words);
+		snew(mv, u8_t, (param.max_block_size + 1) * param.max_words);
+	}
+
+	virtual ~BitVectorAligner() {
+		delete align;
+		delete result;
+		sfree(peq);
+		sfree(pv);
+		sfree(mv);
+	}
+
+	virtual bool go(const char* query, const int qstart, const int qsize,
+			const char* target, const int tstart, const int tsize,
+			const int min_aln_size);
+
+	virtual int query_start() const {
+		return result->query_start;
+	}
+
+	virtual int query_end() const {
+		return result->query_end;
+	}
+
+	virtual int target_start() const {
+		return result->target_start;
+	}
+
+	virtual int target_end() const {
+		return result->target_end;
+	}
+
+	virtual double calc_ident() const {
+		return result->calc_ident();
+	}
+
+	virtual char* query_mapped_string() {
+		return result->out_store1;
+	}
+
+	virtual char* target_mapped_string() {
+		return result->out_store2;
+	}
+
+private:
+	void align_block(const char* Q, const int qsize, const char* T, const int tsize, const bool forward);
+	void extend(const char* query, const int qsize, const char* target, const int tsize, const bool forward);
+	int column_score(const int i, const int j) const;
+
+public:
+	BitVectorAlignParameters	param;
+	Alignment*					align;
+	OutputStore*				result;
+	u8_t*						peq;
+	u8_t*						pv;
+	u8_t*						mv;
+	int							num_words;
+};
+
+#endif // BITVEC_GAPALIGN_H
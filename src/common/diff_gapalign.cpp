@@ -291,21 +291,9 @@ void dw_in_one_direction(const char* query, const int query_size, const char* ta
 	}
 }
 
-bool
-DiffAligner::go(const char* query, const int qstart, const int qsize, 
-				const char* target, const int tstart, const int tsize,
-				const int min_aln_size)
+void
+build_output_store(OutputStore* result, const int qstart, const int tstart)
 {
-	result->init();
-	align->init();
-	dw_in_one_direction(query + qstart - 1, qstart, 
-						target + tstart - 1, tstart,
-						dynq, dynt, align, d_path, 
-						aln_path, &param, result, 0);
-	dw_in_one_direction(query + qstart, qsize - qstart,
-						target + tstart, tsize - tstart,
-						dynq, dynt, align, d_path,
-						aln_path, &param, result, 1);
 	int i, j, k, idx = 0;
 	const char* dt = "ACGT-";
 	for (k = result->left_store_size - 1, i = 0, j = 0; k >= 0; --k, ++idx) {
@@ -344,6 +332,24 @@ DiffAligner::go(const char* query, const int qstart, const int qsize,
 	result->target_end = tstart + j;
 	result->out_store1[result->out_store_size] = '\0';
 	result->out_store2[result->out_store_size] = '\0';
+}
+
+bool
+DiffAligner::go(const char* query, const int qstart, const int qsize, 
+				const char* target, const int tstart, const int tsize,
+				const int min_aln_size)
+{
+	result->init();
+	align->init();
+	dw_in_one_direction(query + qstart - 1, qstart, 
+						target + tstart - 1, tstart,
+						dynq, dynt, align, d_path, 
+						aln_path, &param, result, 0);
+	dw_in_one_direction(query + qstart, qsize - qstart,
+						target + tstart, tsize - tstart,
+						dynq, dynt, align, d_path,
+						aln_path, &param, result, 1);
+	build_output_store(result, qstart, tstart);
 	
 	return result->out_store_size >= min_aln_size;
 }
@@ -119,6 +119,11 @@ struct OutputStore
 	}
 };
 
+// join the left (reversed) and right extensions in result into out_store1/out_store2
+// and compute the mapped ranges around the extension start point (qstart, tstart)
+void
+build_output_store(OutputStore* result, const int qstart, const int tstart);
+
 struct DPathData
 {
     int pre_k, x1, y1, x2, y2;
@@ -1,14 +1,45 @@
 #include "lookup_table.h"
 #include "packed_db.h"
 
+#include <climits>
 #include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RIDX_MAGIC "MECATRI"
+#define RIDX_VERSION 3
+
+// k-mers occurring more often than this are not indexed
+#define RIDX_MAX_KMER_COUNT 128
+
+typedef struct
+{
+	char magic[8];
+	int version;
+	int kmer_size;
+	int window;
+	int num_reads;
+	int wide;
+	int64_t num_bases;
+	int64_t num_kmers;
+} ref_index_header_t;
 
 ref_index*
 destroy_ref_index(ref_index* ridx)
 {
-	safe_free(ridx->kmer_counts);
+	if (ridx->map_addr)
+	{
+		munmap(ridx->map_addr, ridx->map_size);
+	}
+	else
+	{
+		safe_free(ridx->kmer_counts);
+		safe_free(ridx->kmer_offsets);
+	}
 	safe_free(ridx->kmer_starts);
-	safe_free(ridx->kmer_offsets);
 	safe_free(ridx);
 	return NULL;
 }
@@ -35,12 +66,12 @@ fill_ref_index_offsets_func(void* arg)
 	int i, j;
 	for (i = 0; i < num_reads; ++i)
 	{
-		int read_start = v->offset_list->offset_list[i].offset;
+		idx_t read_start = v->offset_list->offset_list[i].offset;
 		int read_size = v->offset_list->offset_list[i].size;
 		uint32_t eit = 0;
 		for (j = 0; j < read_size; ++j)
 		{
-			int k = read_start + j;
+			idx_t k = read_start + j;
 			uint8_t c = PackedDB::get_char(v->data, k);
 			eit = (eit << 2) | c;
 			assert(eit < index_count);
@@ -48,7 +79,7 @@ fill_ref_index_offsets_func(void* arg)
 			{
 				if (index->kmer_starts[eit] && eit >= riti->min_key && eit <= riti->max_key)
 				{
-					index->kmer_starts[eit][index->kmer_counts[eit]] = k + 1 - kmer_size;
+					set_ref_index_position(index, eit, index->kmer_counts[eit], k + 1 - kmer_size);
 					++index->kmer_counts[eit];
 				}
 				eit <<= leftnum;
@@ -60,24 +91,144 @@ fill_ref_index_offsets_func(void* arg)
 	return NULL;
 }
 
+// Thomas Wang's integer hash, a permutation of the 2k-bit k-mers, so that
+// low complexity k-mers such as poly-A do not always become minimizers
+static inline uint32_t
+hash_kmer(uint64_t key, const uint64_t mask)
+{
+	key = (~key + (key << 21)) & mask;
+	key = key ^ key >> 24;
+	key = ((key + (key << 3)) + (key << 8)) & mask;
+	key = key ^ key >> 14;
+	key = ((key + (key << 2)) + (key << 4)) & mask;
+	key = key ^ key >> 28;
+	key = (key + (key << 31)) & mask;
+	return key;
+}
+
+int
+extract_minimizers(const char* s, const int size, const int kmer_size, const int window, int* kmer_ids, int* positions)
+{
+	const int max_window = 256;
+	r_assert(window > 0 && window <= max_window);
+	const int num_kmers = size - kmer_size + 1;
+	if (num_kmers <= 0) return 0;
+	const uint64_t mask = (1ULL << (2 * kmer_size)) - 1;
+	// the hashes and k-mers of the last window k-mers
+	uint32_t ring_hash[max_window], ring_kmer[max_window];
+	int num_mins = 0, min_pos = -1;
+	uint32_t min_hash = 0, eit = 0;
+	for (int j = 0; j < kmer_size - 1; ++j) eit = (eit << 2) | s[j];
+	for (int i = 0; i < num_kmers; ++i)
+	{
+		eit = ((eit << 2) | s[i + kmer_size - 1]) & mask;
+		const int r = i % window;
+		ring_kmer[r] = eit;
+		ring_hash[r] = hash_kmer(eit, mask);
+		if (min_pos >= 0 && min_pos <= i - window)
+		{
+			// the minimizer left the window, look for the leftmost smallest one again
+			min_pos = i - window + 1;
+			min_hash = ring_hash[min_pos % window];
+			for (int p = min_pos + 1; p <= i; ++p)
+				if (ring_hash[p % window] < min_hash) { min_hash = ring_hash[p % window]; min_pos = p; }
+		}
+		else if (min_pos < 0 || ring_hash[r] < min_hash)
+		{
+			min_hash = ring_hash[r];
+			min_pos = i;
+		}
+		// a sequence shorter than a window still gets its smallest k-mer
+		if (i < window - 1 && i < num_kmers - 1) continue;
+		if (num_mins == 0 || positions[num_mins - 1] != min_pos)
+		{
+			kmer_ids[num_mins] = ring_kmer[min_pos % window];
+			positions[num_mins] = min_pos;
+			++num_mins;
+		}
+	}
+	return num_mins;
+}
+
+// only the minimizers of every read are indexed, there are few enough of
+// them to fill the offset lists in one thread
+static void
+create_minimizer_ref_index(ref_index* index, volume_t* v, const int kmer_size, const int window)
+{
+	uint32_t index_count = 1 << (kmer_size * 2);
+	int num_reads = v->num_reads;
+	char* seq;
+	int* kmer_ids;
+	int* positions;
+	safe_malloc(seq, char, MAX_SEQ_SIZE);
+	safe_malloc(kmer_ids, int, MAX_SEQ_SIZE);
+	safe_malloc(positions, int, MAX_SEQ_SIZE);
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (int i = 0; i != num_reads; ++i)
+		{
+			idx_t read_start = v->offset_list->offset_list[i].offset;
+			extract_one_seq(v, i, seq);
+			int n = extract_minimizers(seq, v->offset_list->offset_list[i].size, kmer_size, window, kmer_ids, positions);
+			for (int j = 0; j < n; ++j)
+			{
+				const int eit = kmer_ids[j];
+				if (pass == 0) ++index->kmer_counts[eit];
+				else if (index->kmer_starts[eit]) set_ref_index_position(index, eit, index->kmer_counts[eit]++, read_start + positions[j]);
+			}
+		}
+		if (pass) break;
+		
+		idx_t num_kmers = 0;
+		for (uint32_t i = 0; i != index_count; ++i) 
+		{
+			if (index->kmer_counts[i] > RIDX_MAX_KMER_COUNT) index->kmer_counts[i] = 0;
+			num_kmers += index->kmer_counts[i];
+		}
+		printf("number of minimizers: %lld\n", (long long)num_kmers);
+		const size_t pos_size = ref_index_position_size(index);
+		safe_malloc(index->kmer_offsets, char, num_kmers * pos_size);
+		safe_malloc(index->kmer_starts, void*, index_count);
+		num_kmers = 0;
+		for (uint32_t i = 0; i != index_count; ++i)
+		{
+			index->kmer_starts[i] = index->kmer_counts[i] ? (char*)index->kmer_offsets + num_kmers * pos_size : NULL;
+			num_kmers += index->kmer_counts[i];
+			index->kmer_counts[i] = 0;
+		}
+	}
+	safe_free(seq);
+	safe_free(kmer_ids);
+	safe_free(positions);
+}
+
 ref_index*
-create_ref_index(volume_t* v, int kmer_size, int num_threads)
+create_ref_index(volume_t* v, int kmer_size, const int window, int num_threads)
 {
 	DynamicTimer dtimer(__func__);
 	uint32_t index_count = 1 << (kmer_size * 2);
 	uint32_t leftnum = 34 - 2 * kmer_size;
 	ref_index* index = (ref_index*)malloc(sizeof(ref_index));
+	index->wide = v->curr > INT_MAX;
+	index->window = window;
+	index->map_addr = NULL;
+	index->map_size = 0;
 	safe_calloc(index->kmer_counts, int, index_count);
 	int num_reads = v->num_reads;
 	for (uint32_t i = 0; i != index_count; ++i) assert(index->kmer_counts[i] == 0);
+	if (window)
+	{
+		create_minimizer_ref_index(index, v, kmer_size, window);
+		return index;
+	}
 	for (int i = 0; i != num_reads; ++i)
 	{
-		int read_start = v->offset_list->offset_list[i].offset;
+		idx_t read_start = v->offset_list->offset_list[i].offset;
 		int read_size = v->offset_list->offset_list[i].size;
 		uint32_t eit = 0;
 		for (int j = 0; j < read_size; ++j)
 		{
-			int k = read_start + j;
+			idx_t k = read_start + j;
 			uint8_t c = PackedDB::get_char(v->data, k);
 			assert(c>= 0 && c < 4);
 			eit = (eit << 2) | c;
@@ -91,29 +242,30 @@ create_ref_index(volume_t* v, int kmer_size, int num_threads)
 		}
 	}
 	
-	int num_kmers = 0;
+	idx_t num_kmers = 0;
 	for (uint32_t i = 0; i != index_count; ++i) 
 	{
-		if (index->kmer_counts[i] > 128) index->kmer_counts[i] = 0;
+		if (index->kmer_counts[i] > RIDX_MAX_KMER_COUNT) index->kmer_counts[i] = 0;
 		num_kmers += index->kmer_counts[i];
 	}
-	printf("number of kmers: %d\n", num_kmers);
-	safe_malloc(index->kmer_offsets, int, num_kmers);
-	safe_malloc(index->kmer_starts, int*, index_count);
+	printf("number of kmers: %lld\n", (long long)num_kmers);
+	const size_t pos_size = ref_index_position_size(index);
+	safe_malloc(index->kmer_offsets, char, num_kmers * pos_size);
+	safe_malloc(index->kmer_starts, void*, index_count);
 	
 	if (v->curr < 10 * 1000000) num_threads = 1;
-	int kmers_per_thread = (num_kmers + num_threads - 1) / num_threads;
+	idx_t kmers_per_thread = (num_kmers + num_threads - 1) / num_threads;
 	fprintf(stderr, "%d threads are used for filling offset lists.\n", num_threads);
 	uint32_t hash_boundaries[2 * num_threads];
 	uint32_t L = 0;
 	num_kmers = 0;
-	int kmer_cnt = 0;
+	idx_t kmer_cnt = 0;
 	int tid = 0;
 	for (uint32_t i = 0; i != index_count; ++i)
 	{
 		if (index->kmer_counts[i])
 		{
-			index->kmer_starts[i] = index->kmer_offsets + num_kmers;
+			index->kmer_starts[i] = (char*)index->kmer_offsets + num_kmers * pos_size;
 			num_kmers += index->kmer_counts[i];
 			kmer_cnt += index->kmer_counts[i];
 			index->kmer_counts[i] = 0;
@@ -158,3 +310,112 @@ create_ref_index(volume_t* v, int kmer_size, int num_threads)
 	
 	return index;
 }
+
+void
+generate_ref_index_file_name(const char* vol_name, char* ridx_file_name)
+{
+	strcpy(ridx_file_name, vol_name);
+	strcat(ridx_file_name, ".ridx");
+}
+
+void
+dump_ref_index(const char* ridx_file_name, ref_index* ridx, volume_t* v, const int kmer_size)
+{
+	DynamicTimer dtimer(__func__);
+	uint32_t index_count = 1 << (kmer_size * 2);
+	ref_index_header_t header;
+	memset(&header, 0, sizeof(ref_index_header_t));
+	strcpy(header.magic, RIDX_MAGIC);
+	header.version = RIDX_VERSION;
+	header.kmer_size = kmer_size;
+	header.window = ridx->window;
+	header.num_reads = v->num_reads;
+	header.wide = ridx->wide;
+	header.num_bases = v->curr;
+	header.num_kmers = 0;
+	for (uint32_t i = 0; i != index_count; ++i) header.num_kmers += ridx->kmer_counts[i];
+	
+	// write to a private name first so that concurrent readers never see a partial index
+	char tmp_name[2048];
+	sprintf(tmp_name, "%s.%d.tmp", ridx_file_name, (int)getpid());
+	FILE* out = fopen(tmp_name, "wb");
+	if (!out) { LOG(stderr, "failed to open file \'%s\'.", tmp_name); exit(1); }
+	// 1) header
+	SAFE_WRITE(&header, ref_index_header_t, 1, out);
+	// 2) kmer counts
+	SAFE_WRITE(ridx->kmer_counts, int, index_count, out);
+	// 3) kmer offsets, grouped by kmer in the order of the counts
+	for (uint32_t i = 0; i != index_count; ++i)
+		if (ridx->kmer_counts[i]) SAFE_WRITE(ridx->kmer_starts[i], char, ref_index_position_size(ridx) * ridx->kmer_counts[i], out);
+	fclose(out);
+	if (rename(tmp_name, ridx_file_name))
+	{
+		LOG(stderr, "failed to rename \'%s\' to \'%s\'.", tmp_name, ridx_file_name);
+		exit(1);
+	}
+}
+
+ref_index*
+load_ref_index(const char* ridx_file_name, volume_t* v, const int kmer_size, const int window)
+{
+	int fd = open(ridx_file_name, O_RDONLY);
+	if (fd == -1) return NULL;
+	struct stat sbuf;
+	if (fstat(fd, &sbuf) || (size_t)sbuf.st_size < sizeof(ref_index_header_t)) { close(fd); return NULL; }
+	size_t map_size = sbuf.st_size;
+	void* map_addr = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map_addr == MAP_FAILED) return NULL;
+	
+	uint32_t index_count = 1 << (kmer_size * 2);
+	const ref_index_header_t* header = (const ref_index_header_t*)map_addr;
+	const int wide = v->curr > INT_MAX;
+	const size_t pos_size = wide ? sizeof(idx_t) : sizeof(int);
+	size_t expected_size = sizeof(ref_index_header_t) + sizeof(int) * (size_t)index_count + pos_size * header->num_kmers;
+	if (strcmp(header->magic, RIDX_MAGIC)
+		||
+		header->version != RIDX_VERSION
+		||
+		header->kmer_size != kmer_size
+		||
+		header->window != window
+		||
+		header->num_reads != v->num_reads
+		||
+		header->num_bases != v->curr
+		||
+		header->wide != wide
+		||
+		map_size != expected_size)
+	{
+		LOG(stderr, "index \'%s\' does not match the volume, ignore it.", ridx_file_name);
+		munmap(map_addr, map_size);
+		return NULL;
+	}
+	madvise(map_addr, map_size, MADV_WILLNEED);
+	
+	ref_index* index = (ref_index*)malloc(sizeof(ref_index));
+	index->wide = wide;
+	index->window = window;
+	index->map_addr = map_addr;
+	index->map_size = map_size;
+	index->kmer_counts = (int*)((char*)map_addr + sizeof(ref_index_header_t));
+	index->kmer_offsets = index->kmer_counts + index_count;
+	safe_malloc(index->kmer_starts, void*, index_count);
+	int64_t num_kmers = 0;
+	for (uint32_t i = 0; i != index_count; ++i)
+	{
+		if (index->kmer_counts[i])
+		{
+			index->kmer_starts[i] = (char*)index->kmer_offsets + num_kmers * pos_size;
+			num_kmers += index->kmer_counts[i];
+		}
+		else
+		{
+			index->kmer_starts[i] = NULL;
+		}
+	}
+	r_assert(num_kmers == header->num_kmers);
+	LOG(stderr, "load %lld kmers from \'%s\'.", (long long)num_kmers, ridx_file_name);
+	return index;
+}
@@ -5,15 +5,53 @@
 
 typedef struct
 {
-	int*  kmer_counts;
-	int** kmer_starts;
-	int*  kmer_offsets;
+	int*   kmer_counts;
+	// the positions of k-mer i start at kmer_starts[i], they are ints,
+	// or idx_ts if wide is set, which it is for volumes of more than INT_MAX bases
+	void** kmer_starts;
+	void*  kmer_offsets;
+	int    wide;
+	// 0 if every k-mer of the volume is indexed, otherwise only its (window, k) minimizers are
+	int   window;
+	// non-NULL when kmer_counts and kmer_offsets point into a mapped index file
+	void* map_addr;
+	size_t map_size;
 } ref_index;
 
+static inline size_t
+ref_index_position_size(const ref_index* ridx)
+{
+	return ridx->wide ? sizeof(idx_t) : sizeof(int);
+}
+
+static inline void
+set_ref_index_position(ref_index* ridx, const uint32_t kmer, const int i, const idx_t pos)
+{
+	if (ridx->wide) ((idx_t*)ridx->kmer_starts[kmer])[i] = pos;
+	else ((int*)ridx->kmer_starts[kmer])[i] = pos;
+}
+
 ref_index*
 destroy_ref_index(ref_index* ridx);
 
 ref_index*
-create_ref_index(volume_t* v, int kmer_size, const int num_threads);
+create_ref_index(volume_t* v, int kmer_size, const int window, const int num_threads);
+
+// The minimizers of s (2-bit codes): the k-mer of the smallest hash in every
+// window consecutive k-mers, the leftmost one on ties, so a window picks the
+// same k-mer in every sequence it occurs in. Returns their number, kmer_ids
+// and positions are filled in position order.
+int
+extract_minimizers(const char* s, const int size, const int kmer_size, const int window, int* kmer_ids, int* positions);
+
+void
+generate_ref_index_file_name(const char* vol_name, char* ridx_file_name);
+
+void
+dump_ref_index(const char* ridx_file_name, ref_index* ridx, volume_t* v, const int kmer_size);
+
+// returns NULL if the file does not exist or was built for another volume, kmer size or window
+ref_index*
+load_ref_index(const char* ridx_file_name, volume_t* v, const int kmer_size, const int window);
 
 #endif // LOOKUP_TABLE_H
@@ -0,0 +1,275 @@
+#include "pac_decode.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PAC_DECODE_X86 1
+#include <immintrin.h>
+#else
+#define PAC_DECODE_X86 0
+#endif
+
+#define PAC_KERNEL_SCALAR 0
+#define PAC_KERNEL_SSSE3 1
+#define PAC_KERNEL_AVX2 2
+
+static inline u1_t
+pac_get_char(const u1_t* p, const idx_t idx)
+{
+	return p[idx >> 2] >> ((~idx&3)<<1)&3;
+}
+
+// the four bases packed in byte b, in sequence order
+struct byte_decode_table
+{
+	char bases[256][4];
+	byte_decode_table()
+	{
+		for (int b = 0; b < 256; ++b)
+			for (int i = 0; i < 4; ++i)
+				bases[b][i] = (b >> ((3 - i) << 1)) & 3;
+	}
+};
+
+static void
+decode_bytes_scalar(const u1_t* p, const idx_t n, char* s)
+{
+	static const byte_decode_table table;
+	for (idx_t i = 0; i < n; ++i) memcpy(s + 4 * i, table.bases[p[i]], 4);
+}
+
+static void
+reverse_complement_scalar(char* dst, const char* src, const idx_t size)
+{
+	if (dst == src)
+	{
+		idx_t l = 0, r = size;
+		while (l < r)
+		{
+			--r;
+			char a = dst[l], b = dst[r];
+			dst[l] = 3 - b;
+			dst[r] = 3 - a;
+			++l;
+		}
+	}
+	else
+	{
+		for (idx_t i = 0; i < size; ++i) dst[size - 1 - i] = 3 - src[i];
+	}
+}
+
+#if PAC_DECODE_X86
+
+// every byte is split into its two nibbles, the nibbles are translated into
+// two bases each by pshufb, then the four base vectors are interleaved.
+
+__attribute__((target("ssse3")))
+static void
+decode_bytes_ssse3(const u1_t* p, const idx_t n, char* s)
+{
+	const __m128i hi_base = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+	const __m128i lo_base = _mm_setr_epi8(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
+	const __m128i nibble = _mm_set1_epi8(0x0f);
+	idx_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), nibble);
+		__m128i lo = _mm_and_si128(x, nibble);
+		__m128i b0 = _mm_shuffle_epi8(hi_base, hi);
+		__m128i b1 = _mm_shuffle_epi8(lo_base, hi);
+		__m128i b2 = _mm_shuffle_epi8(hi_base, lo);
+		__m128i b3 = _mm_shuffle_epi8(lo_base, lo);
+		__m128i b01l = _mm_unpacklo_epi8(b0, b1), b01h = _mm_unpackhi_epi8(b0, b1);
+		__m128i b23l = _mm_unpacklo_epi8(b2, b3), b23h = _mm_unpackhi_epi8(b2, b3);
+		__m128i* d = (__m128i*)(s + 4 * i);
+		_mm_storeu_si128(d, _mm_unpacklo_epi16(b01l, b23l));
+		_mm_storeu_si128(d + 1, _mm_unpackhi_epi16(b01l, b23l));
+		_mm_storeu_si128(d + 2, _mm_unpacklo_epi16(b01h, b23h));
+		_mm_storeu_si128(d + 3, _mm_unpackhi_epi16(b01h, b23h));
+	}
+	decode_bytes_scalar(p + i, n - i, s + 4 * i);
+}
+
+__attribute__((target("ssse3")))
+static inline __m128i
+rc_16(const __m128i x)
+{
+	const __m128i rev = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	return _mm_xor_si128(_mm_shuffle_epi8(x, rev), _mm_set1_epi8(3));
+}
+
+__attribute__((target("ssse3")))
+static void
+reverse_complement_ssse3(char* dst, const char* src, const idx_t size)
+{
+	if (dst == src)
+	{
+		idx_t l = 0, r = size;
+		for (; r - l >= 32; l += 16, r -= 16)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(dst + l));
+			__m128i b = _mm_loadu_si128((const __m128i*)(dst + r - 16));
+			_mm_storeu_si128((__m128i*)(dst + l), rc_16(b));
+			_mm_storeu_si128((__m128i*)(dst + r - 16), rc_16(a));
+		}
+		reverse_complement_scalar(dst + l, dst + l, r - l);
+	}
+	else
+	{
+		idx_t i = 0;
+		for (; i + 16 <= size; i += 16)
+			_mm_storeu_si128((__m128i*)(dst + size - i - 16), rc_16(_mm_loadu_si128((const __m128i*)(src + i))));
+		reverse_complement_scalar(dst, src + i, size - i);
+	}
+}
+
+__attribute__((target("avx2")))
+static void
+decode_bytes_avx2(const u1_t* p, const idx_t n, char* s)
+{
+	const __m256i hi_base = _mm256_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+											 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+	const __m256i lo_base = _mm256_setr_epi8(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3,
+											 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
+	const __m256i nibble = _mm256_set1_epi8(0x0f);
+	idx_t i = 0;
+	for (; i + 32 <= n; i += 32)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+		__m256i lo = _mm256_and_si256(x, nibble);
+		__m256i b0 = _mm256_shuffle_epi8(hi_base, hi);
+		__m256i b1 = _mm256_shuffle_epi8(lo_base, hi);
+		__m256i b2 = _mm256_shuffle_epi8(hi_base, lo);
+		__m256i b3 = _mm256_shuffle_epi8(lo_base, lo);
+		__m256i b01l = _mm256_unpacklo_epi8(b0, b1), b01h = _mm256_unpackhi_epi8(b0, b1);
+		__m256i b23l = _mm256_unpacklo_epi8(b2, b3), b23h = _mm256_unpackhi_epi8(b2, b3);
+		// unpacking works within 128-bit lanes, q0 holds bytes 0-3 and 16-19, q1 4-7 and 20-23 ...
+		__m256i q0 = _mm256_unpacklo_epi16(b01l, b23l);
+		__m256i q1 = _mm256_unpackhi_epi16(b01l, b23l);
+		__m256i q2 = _mm256_unpacklo_epi16(b01h, b23h);
+		__m256i q3 = _mm256_unpackhi_epi16(b01h, b23h);
+		__m256i* d = (__m256i*)(s + 4 * i);
+		_mm256_storeu_si256(d, _mm256_permute2x128_si256(q0, q1, 0x20));
+		_mm256_storeu_si256(d + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+		_mm256_storeu_si256(d + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+		_mm256_storeu_si256(d + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+	}
+	decode_bytes_ssse3(p + i, n - i, s + 4 * i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i
+rc_32(const __m256i x)
+{
+	const __m256i rev = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+										 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	__m256i y = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, rev), 0x4e);
+	return _mm256_xor_si256(y, _mm256_set1_epi8(3));
+}
+
+__attribute__((target("avx2")))
+static void
+reverse_complement_avx2(char* dst, const char* src, const idx_t size)
+{
+	if (dst == src)
+	{
+		idx_t l = 0, r = size;
+		for (; r - l >= 64; l += 32, r -= 32)
+		{
+			__m256i a = _mm256_loadu_si256((const __m256i*)(dst + l));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(dst + r - 32));
+			_mm256_storeu_si256((__m256i*)(dst + l), rc_32(b));
+			_mm256_storeu_si256((__m256i*)(dst + r - 32), rc_32(a));
+		}
+		reverse_complement_ssse3(dst + l, dst + l, r - l);
+	}
+	else
+	{
+		idx_t i = 0;
+		for (; i + 32 <= size; i += 32)
+			_mm256_storeu_si256((__m256i*)(dst + size - i - 32), rc_32(_mm256_loadu_si256((const __m256i*)(src + i))));
+		reverse_complement_ssse3(dst, src + i, size - i);
+	}
+}
+
+#endif // PAC_DECODE_X86
+
+// MECAT_PAC_KERNEL=scalar|ssse3 restricts the kernel, e.g. for benchmarking
+static int
+detect_kernel()
+{
+	int kernel = PAC_KERNEL_SCALAR;
+#if PAC_DECODE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) kernel = PAC_KERNEL_AVX2;
+	else if (__builtin_cpu_supports("ssse3")) kernel = PAC_KERNEL_SSSE3;
+#endif
+	const char* limit = getenv("MECAT_PAC_KERNEL");
+	if (limit && strcmp(limit, "scalar") == 0) kernel = PAC_KERNEL_SCALAR;
+	else if (limit && strcmp(limit, "ssse3") == 0 && kernel > PAC_KERNEL_SSSE3) kernel = PAC_KERNEL_SSSE3;
+	return kernel;
+}
+
+static int
+get_kernel()
+{
+	static const int kernel = detect_kernel();
+	return kernel;
+}
+
+const char*
+pac_decode_kernel_name()
+{
+	static const char* names[] = { "scalar", "ssse3", "avx2" };
+	return names[get_kernel()];
+}
+
+static void
+decode_bytes(const u1_t* p, const idx_t n, char* s)
+{
+#if PAC_DECODE_X86
+	switch (get_kernel())
+	{
+		case PAC_KERNEL_AVX2: decode_bytes_avx2(p, n, s); return;
+		case PAC_KERNEL_SSSE3: decode_bytes_ssse3(p, n, s); return;
+	}
+#endif
+	decode_bytes_scalar(p, n, s);
+}
+
+void
+pac_decode(const u1_t* pac, const idx_t from, const idx_t to, char* seq)
+{
+	idx_t i = from;
+	for (; i < to && (i & 3); ++i) *seq++ = pac_get_char(pac, i);
+	if (i >= to) return;
+	const idx_t nbytes = (to - i) >> 2;
+	decode_bytes(pac + (i >> 2), nbytes, seq);
+	seq += 4 * nbytes;
+	i += 4 * nbytes;
+	for (; i < to; ++i) *seq++ = pac_get_char(pac, i);
+}
+
+void
+reverse_complement_codes(char* dst, const char* src, const idx_t size)
+{
+#if PAC_DECODE_X86
+	switch (get_kernel())
+	{
+		case PAC_KERNEL_AVX2: reverse_complement_avx2(dst, src, size); return;
+		case PAC_KERNEL_SSSE3: reverse_complement_ssse3(dst, src, size); return;
+	}
+#endif
+	reverse_complement_scalar(dst, src, size);
+}
+
+void
+pac_decode_rc(const u1_t* pac, const idx_t from, const idx_t to, char* seq)
+{
+	if (to <= from) return;
+	pac_decode(pac, from, to, seq);
+	reverse_complement_codes(seq, seq, to - from);
+}
@@ -0,0 +1,26 @@
+#ifndef PAC_DECODE_H
+#define PAC_DECODE_H
+
+#include "defs.h"
+
+// 2-bit packed sequences store base idx in bits ((~idx&3)<<1) of byte idx >> 2,
+// see PackedDB::set_char(). The routines below work on whole bytes and pick
+// AVX2 or SSSE3 kernels at run time, falling back to a table driven scalar path.
+
+// decode bases [from, to) of pac into seq, one code (0 - 3) per byte
+void
+pac_decode(const u1_t* pac, const idx_t from, const idx_t to, char* seq);
+
+// decode bases [from, to) of pac into seq as their reverse complement
+void
+pac_decode_rc(const u1_t* pac, const idx_t from, const idx_t to, char* seq);
+
+// dst[size - 1 - i] = 3 - src[i], dst and src may be the same buffer
+void
+reverse_complement_codes(char* dst, const char* src, const idx_t size);
+
+// name of the kernel selected at run time, "avx2", "ssse3" or "scalar"
+const char*
+pac_decode_kernel_name();
+
+#endif // PAC_DECODE_H
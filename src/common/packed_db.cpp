@@ -1,10 +1,16 @@
 #include "packed_db.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <fstream>
 #include <string>
 
 #include "defs.h"
 #include "fasta_reader.h"
+#include "split_database.h"
 
 using namespace std;
 
@@ -36,10 +42,11 @@ PackedDB::load_pac(const char* path, idx_t& size)
 }
 
 void
-PackedDB::dump_idx(PODArray<SeqIndex>& idx_list, const char* path)
+PackedDB::dump_idx(PODArray<SeqIndex>& idx_list, const char* path, const char* header)
 {
     ofstream out;
     open_fstream(out, path, ios::out);
+    if (header) out << header << "\n";
     idx_t i = 0, n = idx_list.size();
     for (i = 0; i < n; ++i)
         out << idx_list[i].id << "\t" << idx_list[i].offset << "\t" << idx_list[i].size << "\n";
@@ -47,24 +54,44 @@ PackedDB::dump_idx(PODArray<SeqIndex>& idx_list, const char* path)
 }
 
 void
-PackedDB::load_idx(const char* path, PODArray<SeqIndex>& idx_list)
+PackedDB::load_idx(const char* path, PODArray<SeqIndex>& idx_list, string* header)
 {
     ifstream in;
     open_fstream(in, path, ios::in);
     SeqIndex si;
     idx_list.clear();
+    if (header) header->clear();
+    if (in.peek() == '#')
+    {
+        string line;
+        getline(in, line);
+        if (header) *header = line;
+    }
     while(in >> si.id >> si.offset >> si.size) idx_list.push_back(si);
     close_fstream(in);
 }
 
+// written under a private name and renamed, so that concurrent readers never see a partial file
 void
-PackedDB::dump_packed_db(const char* path)
+PackedDB::dump_packed_db(const char* path, const char* source)
 {
-    string n;
+    string n, tmp, header;
+    char suffix[64];
+    sprintf(suffix, ".%d.tmp", (int)getpid());
     generate_pac_name(path, n);
-    dump_pac(pac, db_size, n.data());
+    tmp = n + suffix;
+    dump_pac(pac, db_size, tmp.data());
+    if (rename(tmp.data(), n.data())) ERROR("failed to rename '%s' to '%s'", tmp.data(), n.data());
     generate_idx_name(path, n);
-    dump_idx(seq_idx, n.data());
+    tmp = n + suffix;
+    if (source)
+    {
+        char num_seqs[64];
+        sprintf(num_seqs, " %lld", (long long)seq_idx.size());
+        header = string("# ") + source + num_seqs;
+    }
+    dump_idx(seq_idx, tmp.data(), source ? header.data() : NULL);
+    if (rename(tmp.data(), n.data())) ERROR("failed to rename '%s' to '%s'", tmp.data(), n.data());
 }
 
 void
@@ -78,6 +105,119 @@ PackedDB::load_packed_db(const char* path)
     load_idx(n.data(), seq_idx);
 }
 
+bool
+PackedDB::map_packed_db(const char* path, const char* source)
+{
+    string n, idx_name;
+    generate_idx_name(path, idx_name);
+    if (access(idx_name.data(), R_OK)) return false;
+    generate_pac_name(path, n);
+    int fd = open(n.data(), O_RDONLY);
+    if (fd == -1) return false;
+    struct stat sbuf;
+    if (fstat(fd, &sbuf) || (size_t)sbuf.st_size < sizeof(idx_t)) { close(fd); return false; }
+    const size_t size = sbuf.st_size;
+    // MAP_POPULATE reads the whole file in now, the pages come from the page cache if another process has it mapped
+    void* addr = mmap(NULL, size, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return false;
+    idx_t num_bases;
+    memcpy(&num_bases, (const char*)addr + size - sizeof(idx_t), sizeof(idx_t));
+    if (num_bases < 0 || (size_t)(num_bases + 3) / 4 + sizeof(idx_t) != size)
+    {
+        LOG(stderr, "'%s' is corrupted, ignore it.", n.data());
+        munmap(addr, size);
+        return false;
+    }
+
+    // the .pac and the .idx are renamed into place one after the other, so a
+    // reader may see a new .pac with an old .idx, or the other way round
+    PODArray<SeqIndex> idx_list;
+    string header;
+    load_idx(idx_name.data(), idx_list, &header);
+    const idx_t nr = idx_list.size();
+    const idx_t indexed_bases = nr ? idx_list[nr - 1].offset + idx_list[nr - 1].size : 0;
+    if (source)
+    {
+        char num_seqs[64];
+        sprintf(num_seqs, " %lld", (long long)nr);
+        if (header != string("# ") + source + num_seqs)
+        {
+            LOG(stderr, "'%s' is not a packed copy of the current sequences, ignore it.", idx_name.data());
+            munmap(addr, size);
+            return false;
+        }
+    }
+    if (indexed_bases != num_bases)
+    {
+        LOG(stderr, "'%s' does not match the packed sequences, ignore it.", idx_name.data());
+        munmap(addr, size);
+        return false;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(addr, size, MADV_HUGEPAGE);
+#endif
+    
+    destroy();
+    map_addr = addr;
+    map_size = size;
+    pac = (u1_t*)addr;
+    db_size = max_db_size = num_bases;
+    seq_idx.clear();
+    seq_idx.push_back(idx_list.data(), nr);
+    return true;
+}
+
+void
+PackedDB::destroy()
+{
+    if (map_addr) munmap(map_addr, map_size);
+    else if (pac) safe_free(pac);
+    pac = NULL;
+    map_addr = NULL;
+    map_size = 0;
+    db_size = max_db_size = 0;
+}
+
+void
+PackedDB::open_fasta_db(const char* fasta)
+{
+    DynamicTimer dtimer(__func__);
+    string prefix = fasta;
+    prefix += ".packed";
+    string pac_name;
+    generate_pac_name(prefix.data(), pac_name);
+    struct stat fasta_stat;
+    if (stat(fasta, &fasta_stat)) ERROR("failed to stat '%s'", fasta);
+    // the size, mtime and checksum of the fasta file, like the manifest of mecat2pw.
+    // The checksum only samples the file, so an edit that keeps the size is caught by the mtime.
+    char source[128];
+    sprintf(source, "%lld %lld %llu", (long long)fasta_stat.st_size, (long long)fasta_stat.st_mtime,
+            (unsigned long long)sample_file_checksum(fasta, fasta_stat.st_size));
+    if (map_packed_db(prefix.data(), source))
+    {
+        LOG(stderr, "map %lld reads from '%s'", (long long)num_seqs(), pac_name.data());
+        return;
+    }
+    
+    load_fasta_db(fasta);
+    // the packed copy is only a cache, the run goes on if it cannot be written
+    string tmp = pac_name + ".w";
+    FILE* test = fopen(tmp.data(), "w");
+    if (!test)
+    {
+        LOG(stderr, "cannot write '%s', the reads will be parsed again next time", pac_name.data());
+        return;
+    }
+    fclose(test);
+    remove(tmp.data());
+    dump_packed_db(prefix.data(), source);
+    // switch to the mapped copy, so this process shares it with the others too.
+    // If another process replaced it in the meantime, keep the loaded reads.
+    if (!map_packed_db(prefix.data(), source))
+        LOG(stderr, "cannot map '%s', use the reads loaded from '%s'", pac_name.data(), fasta);
+}
+
 void
 PackedDB::pack_fasta_db(const char* path, const char* output_prefix, const idx_t min_size)
 {
@@ -134,6 +274,7 @@ PackedDB::pack_fasta_db(const char* path, const char* output_prefix, const idx_t
 void PackedDB::add_one_seq(const Sequence& seq)
 {
 	SeqIndex si;
+	si.id = seq_idx.size();
 	si.size = seq.size();
 	si.offset = db_size;
 	seq_idx.push_back(si);
@@ -164,6 +305,7 @@ void PackedDB::add_one_seq(const Sequence& seq)
 void PackedDB::add_one_seq(const char* seq, const idx_t size)
 {
 	SeqIndex si;
+	si.id = seq_idx.size();
 	si.size = size;
 	si.offset = db_size;
 	seq_idx.push_back(si);
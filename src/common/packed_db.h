@@ -2,6 +2,7 @@
 #define PACKED_DB_H
 
 #include "defs.h"
+#include "pac_decode.h"
 #include "sequence.h"
 
 class PackedDB
@@ -15,7 +16,7 @@ public:
     };
 
 public:
-    PackedDB() : pac(NULL), db_size(0), max_db_size(0) {}
+    PackedDB() : pac(NULL), db_size(0), max_db_size(0), map_addr(NULL), map_size(0) {}
     ~PackedDB() { destroy(); }
 	void reserve(const idx_t& size)
 	{
@@ -31,42 +32,14 @@ public:
 		const index_t offset = seq_idx[id].offset;
 		const index_t size = seq_idx[id].size;
 		r_assert(size == size_in_ovlp);
-		index_t idx = 0;
-		if (fwd)
-		{
-			for (index_t i = 0; i < size; ++i)
-			{
-				uint1 c = get_char(offset + i);
-				seq[idx++] = c;
-			}
-		}
-		else
-		{
-			for (index_t i = size - 1; i >= 0; --i)
-			{
-				uint1 c = get_char(offset + i);
-				c = 3 - c;
-				seq[idx++] = c;
-			}
-		}
+		if (fwd) pac_decode(pac, offset, offset + size, seq);
+		else pac_decode_rc(pac, offset, offset + size, seq);
 	}
 
     void get_sequence(const idx_t from, const idx_t to, const bool forward, char* seq) const
     {
-        idx_t idx = 0;
-        if (forward)
-            for(idx_t i = from; i < to; ++i)
-            {
-                u1_t c = get_char(pac, i);
-                seq[idx++] = c;
-            }
-        else
-            for(idx_t i = to - 1; i >= from; --i)
-            {
-                u1_t c = get_char(pac, i);
-                c = 3 - c;
-                seq[idx++] = c;
-            }
+        if (forward) pac_decode(pac, from, to, seq);
+        else pac_decode_rc(pac, from, to, seq);
     }
 
     void get_sequence(const idx_t rid, const bool forward, char* seq) const
@@ -122,7 +95,7 @@ public:
     idx_t offset_to_rid(const idx_t offset) const;
     void add_one_seq(const Sequence& seq);
 	void add_one_seq(const char* seq, const idx_t size);
-    void destroy() { if (pac) safe_free(pac); db_size = max_db_size = 0; }
+    void destroy();
 	void clear() { seq_idx.clear(); db_size = 0; memset(pac, 0, (max_db_size + 3)/4); }
 
     static void generate_pac_name(const char* prefix, std::string& ret)
@@ -137,20 +110,34 @@ public:
     }
     static void dump_pac(u1_t* p, const idx_t size, const char* path);
     static u1_t* load_pac(const char* path, idx_t& size);
-    static void dump_idx(PODArray<SeqIndex>& idx_list, const char* path);
-    static void load_idx(const char* path, PODArray<SeqIndex>& idx_list);
+    // header is an optional first line of the .idx, which starts with '#'
+    static void dump_idx(PODArray<SeqIndex>& idx_list, const char* path, const char* header = NULL);
+    static void load_idx(const char* path, PODArray<SeqIndex>& idx_list, std::string* header = NULL);
 	
-    void dump_packed_db(const char* path);
+    // source describes where the sequences came from, it is kept in the .idx
+    // together with the number of sequences
+    void dump_packed_db(const char* path, const char* source = NULL);
     void load_packed_db(const char* path);
+    // maps path.pac read-only instead of reading it, so processes that open
+    // the same database share one copy in the page cache. If source is given,
+    // it must match the one the database was dumped with. Nothing is changed
+    // if false is returned.
+    bool map_packed_db(const char* path, const char* source = NULL);
 	
 	static void pack_fasta_db(const char* fasta, const char* output_prefix, const idx_t min_size);
 	void load_fasta_db(const char* fasta);
+	// maps the packed copy fasta.packed.pac/.idx if it was made from a fasta file
+	// of the same size, mtime and checksum, otherwise loads the fasta file and writes
+	// the packed copy for the next process
+	void open_fasta_db(const char* fasta);
 
 private:
     u1_t*   pac;
     idx_t   db_size;
     idx_t   max_db_size;
     PODArray<SeqIndex> seq_idx;
+    void*   map_addr;
+    size_t  map_size;
 };
 
 #endif // PACKED_DB_H
@@ -54,6 +54,7 @@ public:
     const reference operator[](const idx_t idx) const { return data_[idx]; }
     idx_t size() { return used_size_; }
     idx_t size() const { return used_size_; }
+    idx_t capacity() const { return alloc_size_; }
     pointer data() { return data_; }
     const pointer data() const { return data_; }
     void clear() { used_size_ = 0; }
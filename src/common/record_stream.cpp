@@ -0,0 +1,238 @@
+#include "record_stream.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+#define RECORD_STREAM_MAGIC "MECATRS"
+#define RECORD_STREAM_VERSION 1
+
+// records are converted and written this many at a time
+#define RECORD_STREAM_WRITE_BATCH 4096
+
+static int
+record_size_of(const int record_type)
+{
+	return record_type == RECORD_STREAM_M4 ? sizeof(M4BinaryRecord) : sizeof(CandidateBinaryRecord);
+}
+
+void
+write_record_stream_header(ostream& out, const int record_type, const int has_ext)
+{
+	record_stream_header_t header;
+	memset(&header, 0, sizeof(record_stream_header_t));
+	strcpy(header.magic, RECORD_STREAM_MAGIC);
+	header.version = RECORD_STREAM_VERSION;
+	header.record_type = record_type;
+	header.record_size = record_size_of(record_type);
+	header.has_ext = has_ext;
+	out.write((const char*)&header, sizeof(record_stream_header_t));
+}
+
+bool
+read_record_stream_header(const char* path, record_stream_header_t* header)
+{
+	FILE* in = fopen(path, "rb");
+	if (!in) return false;
+	size_t n = fread(header, sizeof(record_stream_header_t), 1, in);
+	fclose(in);
+	if (n != 1) return false;
+	if (memcmp(header->magic, RECORD_STREAM_MAGIC, sizeof(RECORD_STREAM_MAGIC))) return false;
+	if (header->version != RECORD_STREAM_VERSION) ERROR("'%s' is a record stream of version %d, version %d is expected", path, header->version, RECORD_STREAM_VERSION);
+	if (header->record_type != RECORD_STREAM_CANDIDATE && header->record_type != RECORD_STREAM_M4) ERROR("'%s': unknown record type %d", path, header->record_type);
+	if (header->record_size != record_size_of(header->record_type)) ERROR("'%s': corrupted header", path);
+	return true;
+}
+
+void
+write_candidate_binary_records(ostream& out, const ExtensionCandidate* ec_list, const int num_ec)
+{
+	CandidateBinaryRecord buf[RECORD_STREAM_WRITE_BATCH];
+	memset(buf, 0, sizeof(buf));
+	for (int i = 0; i < num_ec; i += RECORD_STREAM_WRITE_BATCH)
+	{
+		const int n = std::min(num_ec - i, RECORD_STREAM_WRITE_BATCH);
+		for (int k = 0; k < n; ++k)
+		{
+			const ExtensionCandidate& ec = ec_list[i + k];
+			CandidateBinaryRecord& r = buf[k];
+			r.qid = ec.qid;
+			r.sid = ec.sid;
+			r.qext = ec.qext;
+			r.sext = ec.sext;
+			r.score = ec.score;
+			r.qsize = ec.qsize;
+			r.ssize = ec.ssize;
+			r.qdir = ec.qdir;
+			r.sdir = ec.sdir;
+		}
+		out.write((const char*)buf, sizeof(CandidateBinaryRecord) * n);
+	}
+}
+
+void
+write_m4_binary_records(ostream& out, const M4Record* m4_list, const int num_m4)
+{
+	M4BinaryRecord buf[RECORD_STREAM_WRITE_BATCH];
+	memset(buf, 0, sizeof(buf));
+	for (int i = 0; i < num_m4; i += RECORD_STREAM_WRITE_BATCH)
+	{
+		const int n = std::min(num_m4 - i, RECORD_STREAM_WRITE_BATCH);
+		for (int k = 0; k < n; ++k)
+		{
+			const M4Record& m4 = m4_list[i + k];
+			M4BinaryRecord& r = buf[k];
+			r.ident = m4ident(m4);
+			r.qid = m4qid(m4);
+			r.sid = m4sid(m4);
+			r.vscore = m4vscore(m4);
+			r.qoff = m4qoff(m4);
+			r.qend = m4qend(m4);
+			r.qsize = m4qsize(m4);
+			r.soff = m4soff(m4);
+			r.send = m4send(m4);
+			r.ssize = m4ssize(m4);
+			r.qext = m4qext(m4);
+			r.sext = m4sext(m4);
+			r.qdir = m4qdir(m4);
+			r.sdir = m4sdir(m4);
+		}
+		out.write((const char*)buf, sizeof(M4BinaryRecord) * n);
+	}
+}
+
+void
+print_candidate_text(ostream& out, const ExtensionCandidate& ec)
+{
+	const char delim = '\t';
+	out << ec.qid << delim
+		<< ec.sid << delim
+		<< ec.qdir << delim
+		<< ec.sdir << delim
+		<< ec.qext << delim
+		<< ec.sext << delim
+		<< ec.score << delim
+		<< ec.qsize << delim
+		<< ec.ssize << "\n";
+}
+
+void
+print_m4record_text(ostream& out, const M4Record& m4, const int has_ext)
+{
+	const char sep = '\t';
+	out << m4qid(m4)    << sep
+	    << m4sid(m4)    << sep
+	    << m4ident(m4) << sep
+	    << m4vscore(m4)   << sep
+	    << m4qdir(m4)   << sep
+	    << m4qoff(m4)   << sep
+	    << m4qend(m4)   << sep
+	    << m4qsize(m4)  << sep
+	    << m4sdir(m4)   << sep
+	    << m4soff(m4)   << sep
+	    << m4send(m4)   << sep
+	    << m4ssize(m4);
+	if (has_ext)
+		out << sep
+			<< m4qext(m4)	<< sep
+			<< m4sext(m4);
+	out << "\n";
+}
+
+OverlapRecordReader::OverlapRecordReader(const char* path)
+	: file_name(path), map_addr(NULL), map_size(0), records(NULL), num_recs(0), next_rec(0), total_size(0)
+{
+	struct stat st;
+	if (stat(path, &st) == 0) total_size = st.st_size;
+	if (!read_record_stream_header(path, &header))
+	{
+		memset(&header, 0, sizeof(record_stream_header_t));
+		header.record_type = -1;
+		header.has_ext = -1;
+		open_fstream(text_in, path, ios::in);
+		return;
+	}
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) ERROR("failed to open file '%s'", path);
+	if (fstat(fd, &st)) ERROR("failed to stat file '%s'", path);
+	map_size = st.st_size;
+	num_recs = (map_size - sizeof(record_stream_header_t)) / header.record_size;
+	if (num_recs)
+	{
+		map_addr = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (map_addr == MAP_FAILED) ERROR("failed to map file '%s'", path);
+		madvise(map_addr, map_size, MADV_SEQUENTIAL);
+		records = (const char*)map_addr + sizeof(record_stream_header_t);
+	}
+	close(fd);
+	if (sizeof(record_stream_header_t) + num_recs * header.record_size != map_size)
+		LOG(stderr, "warning: '%s' ends with an incomplete record, which is ignored", path);
+}
+
+OverlapRecordReader::~OverlapRecordReader()
+{
+	if (map_addr) munmap(map_addr, map_size);
+	else if (text_in.is_open()) close_fstream(text_in);
+}
+
+idx_t
+OverlapRecordReader::bytes_read()
+{
+	if (header.record_type != -1) return sizeof(record_stream_header_t) + next_rec * header.record_size;
+	if (!text_in) return total_size;
+	return text_in.tellg();
+}
+
+bool
+OverlapRecordReader::next(ExtensionCandidate& ec)
+{
+	if (header.record_type == -1) return (bool)(text_in >> ec);
+	if (header.record_type != RECORD_STREAM_CANDIDATE) ERROR("'%s' does not contain candidates", file_name.c_str());
+	if (next_rec == num_recs) return false;
+	const CandidateBinaryRecord* r = (const CandidateBinaryRecord*)records + next_rec;
+	++next_rec;
+	ec.qid = r->qid;
+	ec.sid = r->sid;
+	ec.qdir = r->qdir;
+	ec.sdir = r->sdir;
+	ec.qext = r->qext;
+	ec.sext = r->sext;
+	ec.score = r->score;
+	ec.qsize = r->qsize;
+	ec.ssize = r->ssize;
+	return true;
+}
+
+bool
+OverlapRecordReader::next(M4Record& m4)
+{
+	if (header.record_type == -1)
+	{
+		m4qext(m4) = m4sext(m4) = INVALID_IDX;
+		return (bool)(text_in >> m4);
+	}
+	if (header.record_type != RECORD_STREAM_M4) ERROR("'%s' does not contain M4 records", file_name.c_str());
+	if (next_rec == num_recs) return false;
+	const M4BinaryRecord* r = (const M4BinaryRecord*)records + next_rec;
+	++next_rec;
+	m4ident(m4) = r->ident;
+	m4qid(m4) = r->qid;
+	m4sid(m4) = r->sid;
+	m4vscore(m4) = r->vscore;
+	m4qdir(m4) = r->qdir;
+	m4qoff(m4) = r->qoff;
+	m4qend(m4) = r->qend;
+	m4qsize(m4) = r->qsize;
+	m4sdir(m4) = r->sdir;
+	m4soff(m4) = r->soff;
+	m4send(m4) = r->send;
+	m4ssize(m4) = r->ssize;
+	m4qext(m4) = header.has_ext ? r->qext : INVALID_IDX;
+	m4sext(m4) = header.has_ext ? r->sext : INVALID_IDX;
+	return true;
+}
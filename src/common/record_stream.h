@@ -0,0 +1,90 @@
+#ifndef RECORD_STREAM_H
+#define RECORD_STREAM_H
+
+#include <fstream>
+
+#include "alignment.h"
+
+// A record stream is the binary form of a can or M4 file: a header followed by
+// fixed-width records, which can be mapped and read in place instead of parsed.
+
+#define RECORD_STREAM_CANDIDATE	0
+#define RECORD_STREAM_M4		1
+
+typedef struct
+{
+	char magic[8];
+	i4_t version;
+	i4_t record_type;
+	i4_t record_size;
+	i4_t has_ext;
+} record_stream_header_t;
+
+struct CandidateBinaryRecord
+{
+	i4_t qid, sid, qext, sext, score, qsize, ssize;
+	i1_t qdir, sdir;
+	i2_t reserved;
+};
+
+struct M4BinaryRecord
+{
+	double ident;
+	i4_t qid, sid, vscore;
+	i4_t qoff, qend, qsize;
+	i4_t soff, send, ssize;
+	i4_t qext, sext;
+	i1_t qdir, sdir;
+	i2_t reserved;
+};
+
+void
+write_record_stream_header(std::ostream& out, const int record_type, const int has_ext);
+
+// returns false if path is not a record stream
+bool
+read_record_stream_header(const char* path, record_stream_header_t* header);
+
+void
+write_candidate_binary_records(std::ostream& out, const ExtensionCandidate* ec_list, const int num_ec);
+
+void
+write_m4_binary_records(std::ostream& out, const M4Record* m4_list, const int num_m4);
+
+void
+print_candidate_text(std::ostream& out, const ExtensionCandidate& ec);
+
+void
+print_m4record_text(std::ostream& out, const M4Record& m4, const int has_ext);
+
+// reads the records of a can or M4 file, in text or as a record stream
+class OverlapRecordReader
+{
+public:
+	OverlapRecordReader(const char* path);
+	~OverlapRecordReader();
+
+	bool is_binary() const { return map_addr != NULL; }
+	int record_type() const { return header.record_type; }
+	int has_ext() const { return header.has_ext; }
+	idx_t num_records() const { return num_recs; }
+	// for progress reports
+	idx_t bytes_read();
+	idx_t file_size() const { return total_size; }
+
+	bool next(ExtensionCandidate& ec);
+	bool next(M4Record& m4);
+
+private:
+	std::string					file_name;
+	std::ifstream				text_in;
+	record_stream_header_t		header;
+	void*						map_addr;
+	size_t						map_size;
+	const char*					records;
+	idx_t						num_recs;
+	idx_t						next_rec;
+	idx_t						total_size;
+};
+
+#endif // RECORD_STREAM_H
@@ -1,19 +1,43 @@
 #include "split_database.h"
 
 #include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <fstream>
 #include <string>
 
 #include "packed_db.h"
 #include "fasta_reader.h"
+#include "lookup_table.h"
 
 #define MSS MAX_SEQ_SIZE
 
+#define VOLUME_MAGIC "MECATVL"
+#define VOLUME_VERSION 2
+
+// volume files without this header hold 32-bit offsets and base counts
+typedef struct
+{
+	char magic[8];
+	int version;
+	int num_reads;
+	int start_read_id;
+	int reserved;
+	int64_t num_bases;
+} volume_header_t;
+
+typedef struct {
+    int offset, size;
+} offset32_t;
+
 using namespace std;
 
 int
-get_read_id_from_offset_list(offset_list_t* list, const int offset)
+get_read_id_from_offset_list(offset_list_t* list, const idx_t offset)
 {
 	int n = list->curr;
 	offset_t* a = list->offset_list;
@@ -55,7 +79,7 @@ delete_offset_list_t(offset_list_t* list)
 }
 
 void
-insert_one_offset(offset_list_t* list, const int offset, const int size)
+insert_one_offset(offset_list_t* list, const idx_t offset, const int size)
 {
     if (list->curr >= list->max_size)
     {
@@ -68,7 +92,7 @@ insert_one_offset(offset_list_t* list, const int offset, const int size)
 }
 
 volume_t*
-new_volume_t(int num_reads, int num_bases)
+new_volume_t(int num_reads, idx_t num_bases)
 {
     volume_t* volume = (volume_t*)malloc(sizeof(volume_t));
     volume->num_reads = 0;
@@ -78,6 +102,8 @@ new_volume_t(int num_reads, int num_bases)
     idx_t vol_bytes = (num_bases + 3) / 4;
     safe_calloc(volume->data, uint8_t, vol_bytes);
     volume->offset_list = new_offset_list_t(num_reads);
+    volume->map_addr = NULL;
+    volume->map_size = 0;
     return volume;
 }
 
@@ -95,7 +121,8 @@ volume_t*
 delete_volume_t(volume_t* v)
 {
     v->offset_list = delete_offset_list_t(v->offset_list);
-    free(v->data);
+    if (v->map_addr) munmap(v->map_addr, v->map_size);
+    else free(v->data);
     free(v);
     return NULL;
 }
@@ -110,7 +137,7 @@ add_one_seq(volume_t* volume, const char* s, const int size)
 	for (i = 0; i < size; ++i) 
 	{
 		uint8_t* d = volume->data;
-		int idx = volume->curr;
+		idx_t idx = volume->curr;
 		uint8_t c = s[i];
 		c = encode_table[c];
 		PackedDB::set_char(d, idx, c);
@@ -122,14 +149,9 @@ void
 extract_one_seq(volume_t* v, const int id, char* s)
 {
 	assert(id < v->num_reads);
-	int offset = v->offset_list->offset_list[id].offset;
+	idx_t offset = v->offset_list->offset_list[id].offset;
 	int size = v->offset_list->offset_list[id].size;
-	int i = 0;
-	for (i = 0; i < size; ++i)
-	{
-		int k = offset + i;
-		s[i] = PackedDB::get_char(v->data, k);
-	}
+	pac_decode(v->data, offset, offset + size, s);
 }
 
 void 
@@ -137,17 +159,20 @@ dump_volume(const char* vol_name, volume_t* v)
 {
 	FILE* out = fopen(vol_name, "wb");
 	assert(out);
-	// 1) number of reads
-	SAFE_WRITE(&v->num_reads, int, 1, out);
-	// 2) number of bases
-	SAFE_WRITE(&v->curr, int, 1, out);
-	// 3) start read id
-	SAFE_WRITE(&v->start_read_id, int, 1, out);
-	// 4) offset list
+	// 1) header
+	volume_header_t header;
+	memset(&header, 0, sizeof(volume_header_t));
+	strcpy(header.magic, VOLUME_MAGIC);
+	header.version = VOLUME_VERSION;
+	header.num_reads = v->num_reads;
+	header.start_read_id = v->start_read_id;
+	header.num_bases = v->curr;
+	SAFE_WRITE(&header, volume_header_t, 1, out);
+	// 2) offset list
 	assert(v->offset_list->curr == v->num_reads);
 	SAFE_WRITE(v->offset_list->offset_list, offset_t, v->num_reads, out);
-	// 5) pac
-	int vol_bytes = (v->curr + 3) / 4;
+	// 3) pac
+	idx_t vol_bytes = (v->curr + 3) / 4;
 	SAFE_WRITE(v->data, uint8_t, vol_bytes, out);
 	fclose(out);
 }
@@ -155,28 +180,72 @@ dump_volume(const char* vol_name, volume_t* v)
 volume_t*
 load_volume(const char* vol_name)
 {
-	int num_reads, num_bases;
-	FILE* in = fopen(vol_name, "rb");
-	if (!in) { LOG(stderr, "failed to open file \'%s\'.", vol_name); exit(1); }
+	int fd = open(vol_name, O_RDONLY);
+	if (fd == -1) { LOG(stderr, "failed to open file \'%s\'.", vol_name); exit(1); }
+	struct stat sbuf;
+	if (fstat(fd, &sbuf)) { LOG(stderr, "failed to stat file \'%s\'.", vol_name); exit(1); }
+	const size_t map_size = sbuf.st_size;
+	if (map_size < 3 * sizeof(int)) { LOG(stderr, "\'%s\' is corrupted.", vol_name); exit(1); }
+	void* map_addr = mmap(NULL, map_size, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+	if (map_addr == MAP_FAILED) { LOG(stderr, "failed to map file \'%s\'.", vol_name); exit(1); }
+	close(fd);
+#ifdef MADV_HUGEPAGE
+	madvise(map_addr, map_size, MADV_HUGEPAGE);
+#endif
 	
-	// 1) number of reads
-	SAFE_READ(&num_reads, int, 1, in);
-	// 2) number of bases
-	SAFE_READ(&num_bases, int, 1, in);
+	int num_reads, start_read_id;
+	idx_t num_bases;
+	size_t list_start, list_bytes;
+	const volume_header_t* header = (const volume_header_t*)map_addr;
+	const bool old_format = map_size < sizeof(volume_header_t) || strcmp(header->magic, VOLUME_MAGIC);
+	if (old_format)
+	{
+		// number of reads, number of bases, start read id, then 32-bit offsets
+		const int* old_header = (const int*)map_addr;
+		num_reads = old_header[0];
+		num_bases = old_header[1];
+		start_read_id = old_header[2];
+		list_start = 3 * sizeof(int);
+		list_bytes = sizeof(offset32_t) * (size_t)num_reads;
+	}
+	else
+	{
+		if (header->version != VOLUME_VERSION) 
+		{ LOG(stderr, "\'%s\' is a volume of version %d, version %d is expected.", vol_name, header->version, VOLUME_VERSION); exit(1); }
+		num_reads = header->num_reads;
+		num_bases = header->num_bases;
+		start_read_id = header->start_read_id;
+		list_start = sizeof(volume_header_t);
+		list_bytes = sizeof(offset_t) * (size_t)num_reads;
+	}
+	const size_t vol_bytes = ((size_t)num_bases + 3) / 4;
+	if (num_reads < 0 || num_bases < 0 || list_start + list_bytes + vol_bytes > map_size)
+	{ LOG(stderr, "\'%s\' is corrupted.", vol_name); exit(1); }
 	
-	volume_t* v = new_volume_t(num_reads, num_bases);
+	volume_t* v = (volume_t*)malloc(sizeof(volume_t));
 	v->num_reads = num_reads;
-	v->curr = num_bases;
-	// 3) start read id
-	SAFE_READ(&v->start_read_id, int, 1, in);
-	// 4) offset list
-	SAFE_READ(v->offset_list->offset_list, offset_t, num_reads, in);
+	v->curr = v->max_size = num_bases;
+	v->start_read_id = start_read_id;
+	// the offsets are copied, they are small next to the pac, which stays mapped
+	v->offset_list = new_offset_list_t(num_reads);
 	v->offset_list->curr = num_reads;
-	// 5) pac
-	int vol_bytes = (num_bases + 3) / 4;
-	SAFE_READ(v->data, uint8_t, vol_bytes, in);
-	
-	fclose(in);
+	const char* list = (const char*)map_addr + list_start;
+	if (old_format)
+	{
+		const offset32_t* a = (const offset32_t*)list;
+		for (int i = 0; i < num_reads; ++i)
+		{
+			v->offset_list->offset_list[i].offset = a[i].offset;
+			v->offset_list->offset_list[i].size = a[i].size;
+		}
+	}
+	else
+	{
+		memcpy(v->offset_list->offset_list, list, list_bytes);
+	}
+	v->data = (uint8_t*)list + list_bytes;
+	v->map_addr = map_addr;
+	v->map_size = map_size;
 	return v;
 }
 
@@ -208,21 +277,28 @@ extract_one_seq(ifstream& pac_file, PackedDB::SeqIndex& si, u1_t* buffer, char*
 	memset(buffer, 0, MAX_SEQ_SIZE);
 	pac_file.read((char*)buffer, bytes);
 	const char* dt = get_dna_decode_table();
+	pac_decode(buffer, 0, si.size, seq);
 	idx_t i = 0;
-	for(i = 0; i < si.size; ++i)
-	{
-		u1_t c = PackedDB::get_char(buffer, i);
-		c = dt[c];
-		seq[i] = c;
-	}
+	for(i = 0; i < si.size; ++i) seq[i] = dt[(int)seq[i]];
 	seq[i] = '\0';
 }
 
+static void
+build_volume_ref_index(const char* vol_file_name, volume_t* v, const int kmer_size, const int window, const int num_threads)
+{
+	if (kmer_size <= 0) return;
+	char ridx_file_name[1024];
+	generate_ref_index_file_name(vol_file_name, ridx_file_name);
+	ref_index* ridx = create_ref_index(v, kmer_size, window, num_threads);
+	dump_ref_index(ridx_file_name, ridx, v, kmer_size);
+	destroy_ref_index(ridx);
+}
+
 int
-split_raw_dataset(const char* reads, const char* wrk_dir)
+split_raw_dataset(const char* reads, const char* wrk_dir, const idx_t volume_size, const int kmer_size, const int window, const int num_threads)
 {
 	DynamicTimer dtimer(__func__);
-	volume_t* v = new_volume_t(0, 0);
+	volume_t* v = new_volume_t(0, volume_size + MSS);
 	int vol = 0;
 	int rid = 0;
 	char idx_file_name[1024], vol_file_name[1024];
@@ -237,13 +313,14 @@ split_raw_dataset(const char* reads, const char* wrk_dir)
 		if (rsize == -1) break;
 		++num_reads;
 		num_nucls += rsize;
-		if (v->curr + rsize + 1 > MCS)
+		if (v->curr + rsize + 1 > volume_size)
 		{
 			v->start_read_id = rid;
 			rid += v->num_reads;
 			generate_vol_file_name(wrk_dir, vol++, vol_file_name);
 			fprintf(idx_file, "%s\n", vol_file_name);
 			dump_volume(vol_file_name, v);
+			build_volume_ref_index(vol_file_name, v, kmer_size, window, num_threads);
 			clear_volume_t(v);
 		}
 		add_one_seq(v, read.sequence().data(), rsize);
@@ -257,6 +334,7 @@ split_raw_dataset(const char* reads, const char* wrk_dir)
 		generate_vol_file_name(wrk_dir, vol++, vol_file_name);
 		fprintf(idx_file, "%s\n", vol_file_name);
 		dump_volume(vol_file_name, v);
+		build_volume_ref_index(vol_file_name, v, kmer_size, window, num_threads);
 		clear_volume_t(v);
 	}
 	fclose(idx_file);
@@ -402,3 +480,151 @@ print_volume_names(volume_names_t* vn)
 		fprintf(stderr, "%s\n", name);
 	}
 }
+
+void
+generate_manifest_file_name(const char* wrk_dir, char* manifest_file_name)
+{
+	strcpy(manifest_file_name, wrk_dir);
+	if (manifest_file_name[strlen(manifest_file_name) - 1] != '/') strcat(manifest_file_name, "/");
+	strcat(manifest_file_name, "manifest.txt");
+}
+
+#define MANIFEST_SAMPLE_SIZE (1L << 20)
+
+uint64_t
+sample_file_checksum(const char* path, const off_t file_size)
+{
+	FILE* in = fopen(path, "rb");
+	if (!in) { LOG(stderr, "failed to open file \'%s\'.", path); exit(1); }
+	char* buffer;
+	safe_malloc(buffer, char, MANIFEST_SAMPLE_SIZE);
+	off_t starts[3] = { 0, file_size / 2, file_size - MANIFEST_SAMPLE_SIZE };
+	uint64_t h = 14695981039346656037ULL;
+	for (int i = 0; i < 3; ++i)
+	{
+		off_t s = MAX(starts[i], (off_t)0);
+		fseeko(in, s, SEEK_SET);
+		size_t n = fread(buffer, 1, MANIFEST_SAMPLE_SIZE, in);
+		for (size_t j = 0; j < n; ++j)
+		{
+			h ^= (uint8_t)buffer[j];
+			h *= 1099511628211ULL;
+		}
+	}
+	safe_free(buffer);
+	fclose(in);
+	return h;
+}
+
+typedef struct {
+	char path[PATH_MAX];
+	long long size;
+	long long mtime;
+	unsigned long long checksum;
+} manifest_input_t;
+
+static int
+fill_manifest_input(const char* reads, manifest_input_t* mi)
+{
+	struct stat sbuf;
+	if (!realpath(reads, mi->path) || stat(reads, &sbuf)) return 1;
+	mi->size = sbuf.st_size;
+	mi->mtime = sbuf.st_mtime;
+	mi->checksum = sample_file_checksum(reads, sbuf.st_size);
+	return 0;
+}
+
+static long long
+get_file_size(const char* path)
+{
+	struct stat sbuf;
+	if (stat(path, &sbuf)) return -1;
+	return sbuf.st_size;
+}
+
+void
+dump_split_manifest(const char* reads, const char* wrk_dir, const idx_t volume_size, const int kmer_size, const int window, const int num_vols)
+{
+	manifest_input_t mi;
+	if (fill_manifest_input(reads, &mi)) { LOG(stderr, "failed to stat file \'%s\'.", reads); exit(1); }
+	char idx_file_name[1024], manifest_file_name[1024], tmp_file_name[1100];
+	generate_idx_file_name(wrk_dir, idx_file_name);
+	generate_manifest_file_name(wrk_dir, manifest_file_name);
+	sprintf(tmp_file_name, "%s.%d.tmp", manifest_file_name, (int)getpid());
+	volume_names_t* vn = load_volume_names(idx_file_name, num_vols);
+	r_assert(vn->num_vols == num_vols);
+	
+	FILE* out = fopen(tmp_file_name, "w");
+	if (!out) { LOG(stderr, "failed to open file \'%s\'.", tmp_file_name); exit(1); }
+	fprintf(out, "reads\t%s\n", mi.path);
+	fprintf(out, "size\t%lld\n", mi.size);
+	fprintf(out, "mtime\t%lld\n", mi.mtime);
+	fprintf(out, "checksum\t%llx\n", mi.checksum);
+	fprintf(out, "index\t%lld\t%d\t%d\n", (long long)volume_size, kmer_size, window);
+	fprintf(out, "volumes\t%d\n", num_vols);
+	for (int i = 0; i < num_vols; ++i)
+	{
+		const char* name = get_vol_name(vn, i);
+		fprintf(out, "%s\t%lld\n", name, get_file_size(name));
+	}
+	fclose(out);
+	if (rename(tmp_file_name, manifest_file_name))
+	{
+		LOG(stderr, "failed to rename \'%s\' to \'%s\'.", tmp_file_name, manifest_file_name);
+		exit(1);
+	}
+	delete_volume_names_t(vn);
+}
+
+int
+check_split_manifest(const char* reads, const char* wrk_dir, const idx_t volume_size, const int kmer_size, const int window)
+{
+	char idx_file_name[1024], manifest_file_name[1024];
+	generate_manifest_file_name(wrk_dir, manifest_file_name);
+	generate_idx_file_name(wrk_dir, idx_file_name);
+	FILE* in = fopen(manifest_file_name, "r");
+	if (!in) return -1;
+	
+	manifest_input_t mi, rmi;
+	int num_vols = -1, rkmer_size = -1, rwindow = -1;
+	long long rvolume_size = -1;
+	int r = fscanf(in, "reads\t%4095[^\n]\nsize\t%lld\nmtime\t%lld\nchecksum\t%llx\nindex\t%lld\t%d\t%d\nvolumes\t%d\n",
+				   rmi.path, &rmi.size, &rmi.mtime, &rmi.checksum, &rvolume_size, &rkmer_size, &rwindow, &num_vols);
+	if (r != 8 
+		||
+		rvolume_size != volume_size
+		||
+		rkmer_size != kmer_size
+		||
+		rwindow != window
+		|| 
+		access(idx_file_name, F_OK) 
+		|| 
+		fill_manifest_input(reads, &mi) 
+		|| 
+		strcmp(mi.path, rmi.path) 
+		|| 
+		mi.size != rmi.size 
+		|| 
+		mi.mtime != rmi.mtime 
+		|| 
+		mi.checksum != rmi.checksum)
+	{
+		fclose(in);
+		return -1;
+	}
+	
+	volume_names_t* vn = load_volume_names(idx_file_name, num_vols);
+	char name[1024];
+	long long size;
+	int i = 0;
+	if (vn->num_vols == num_vols)
+		for (i = 0; i < num_vols; ++i)
+		{
+			if (fscanf(in, "%1023[^\t]\t%lld\n", name, &size) != 2) break;
+			if (strcmp(name, get_vol_name(vn, i)) || get_file_size(name) != size) break;
+		}
+	delete_volume_names_t(vn);
+	fclose(in);
+	return (i == num_vols) ? num_vols : -1;
+}
@@ -1,13 +1,16 @@
 #ifndef SPLIT_DATABASE_H
 #define SPLIT_DATABASE_H
 
+#include <sys/types.h>
+
 #include "../common/defs.h"
 
-#define MCS (2140000000L) // max chunk size
+#define MCS (2140000000L) // default max chunk size
 //#define MCS 50000000L
 
 typedef struct {
-    int offset, size;
+    idx_t offset;
+    int size;
 } offset_t;
 
 typedef struct {
@@ -17,14 +20,17 @@ typedef struct {
 
 typedef struct {
     int num_reads;
-    int curr, max_size;
+    idx_t curr, max_size;
 	int start_read_id;
     uint8_t* data;
     offset_list_t* offset_list;
+    // set if data points into a mapped volume file
+    void* map_addr;
+    size_t map_size;
 } volume_t;
 
 volume_t*
-new_volume_t(int num_reads, int num_bases);
+new_volume_t(int num_reads, idx_t num_bases);
 
 void
 clear_volume_t(volume_t* v);
@@ -61,8 +67,10 @@ void
 dump_volume(const char* vol_name, volume_t* v);
 
 int
-get_read_id_from_offset_list(offset_list_t* list, const int offset);
+get_read_id_from_offset_list(offset_list_t* list, const idx_t offset);
 
+// maps the volume file read-only, processes working on the same volume share its pages.
+// Volumes written before 64-bit offsets (no header) are loaded too.
 volume_t*
 load_volume(const char* vol_name);
 
@@ -78,7 +86,25 @@ split_dataset(const char* reads, const char* wrk_dir, int* num_vols);
 void
 extract_one_seq(volume_t* v, const int id, char* s);
 
+// volumes hold at most volume_size bases, if kmer_size > 0, a reference index is built and dumped next to every volume
 int
-split_raw_dataset(const char* reads, const char* wrk_dir);
+split_raw_dataset(const char* reads, const char* wrk_dir, const idx_t volume_size, const int kmer_size, const int window, const int num_threads);
+
+void
+generate_manifest_file_name(const char* wrk_dir, char* manifest_file_name);
+
+// records the dataset, the volume and index options and the volumes it was split into
+void
+dump_split_manifest(const char* reads, const char* wrk_dir, const idx_t volume_size, const int kmer_size, const int window, const int num_vols);
+
+// returns the number of volumes if the volumes in wrk_dir are up to date with reads 
+// and were split and indexed with the same volume size, kmer size and window, -1 otherwise
+int
+check_split_manifest(const char* reads, const char* wrk_dir, const idx_t volume_size, const int kmer_size, const int window);
+
+// FNV-1a over the first, middle and last megabyte of the file,
+// so that checking a multi-hundred-GB dataset does not mean reading all of it.
+uint64_t
+sample_file_checksum(const char* path, const off_t file_size);
 
 #endif // SPLIT_DATABASE_H
@@ -2,6 +2,14 @@
 //#include "smart_assert.h"
 
 #include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#define XDROP_SSE2 1
+#include <emmintrin.h>
+#else
+#define XDROP_SSE2 0
+#endif
 
 using namespace std;
 
@@ -212,6 +220,236 @@ xdrop_align(const char* A,
     return best_score;
 }
 
+#if XDROP_SSE2
+
+// xdrop_align() for reward 1, penalty -1, gap_open 0 and gap_extend 1, eight
+// 16-bit cells at a time. With linear gaps a cell is
+// S[b] = max(S'[b-1] + s, S'[b] - 1, S[b-1] - 1), the last term is resolved
+// by a prefix scan inside the vector. X-drop uses the best score of the cells
+// before the current one in row order, which is a prefix max scan, so the
+// pruning, the end point and the traceback are those of the scalar code.
+// Traceback cells are packed two per byte:
+// bits 0-1 op (0 sub, 1 gap in A, 2 gap in B), bit 2 EXTEND_GAP_A, bit 3 EXTEND_GAP_B.
+
+#define XDROP_NEG_INF (-30000)
+#define XDROP_SIMD_PAD 16
+
+static const u8 kPackedSub = 0;
+static const u8 kPackedGapInA = 1;
+static const u8 kPackedGapInB = 2;
+
+static inline void
+set_packed_script(u8* row, const int k, const u8 code)
+{
+	u8& c = row[k >> 1];
+	if (k & 1) c = (c & 0x0f) | (code << 4);
+	else c = (c & 0xf0) | code;
+}
+
+static inline u8
+get_packed_script(const u8* row, const int k)
+{
+	const u8 code = (row[k >> 1] >> ((k & 1) << 2)) & 0x0f;
+	static const u8 ops[4] = { SCRIPT_SUB, SCRIPT_GAP_IN_A, SCRIPT_GAP_IN_B, SCRIPT_SUB };
+	u8 script = ops[code & 3];
+	if (code & 4) script += SCRIPT_EXTEND_GAP_A;
+	if (code & 8) script += SCRIPT_EXTEND_GAP_B;
+	return script;
+}
+
+// shift the lanes of x up by k, the low k lanes are filled with XDROP_NEG_INF
+#define SHIFT_LANES(x, k, fill) _mm_or_si128(_mm_slli_si128((x), 2 * (k)), (fill))
+
+int
+xdrop_align_sse2(const char* A,
+				 const int M,
+				 const char* B,
+				 const int N,
+				 int x_dropoff,
+				 i2_t* simd_buf,
+				 u8* state_array,
+				 u8** edit_script,
+				 int* edit_start_offset,
+				 GapPrelimEditBlock* edit_block,
+				 const bool forward,
+				 int& ae,
+				 int& be)
+{
+	ae = 0;
+	be = 0;
+	edit_block->clear();
+	if (M <= 0 || N <= 0) return 0;
+	if (x_dropoff < 1) x_dropoff = 1;
+
+	// rows and bases are indexed from -1
+	const int row_size = N + 2 + 2 * XDROP_SIMD_PAD;
+	i2_t* H = simd_buf + 1;
+	i2_t* S = H + row_size;
+	i2_t* Bc = S + row_size;
+	Bc[0] = -1;
+	for (int b = 1; b <= N; ++b) Bc[b] = extract_char<u8>(B, b - 1, forward);
+	for (int b = N + 1; b < row_size - 1; ++b) Bc[b] = -1;
+
+	// row 0
+	edit_script[0] = state_array;
+	edit_start_offset[0] = 0;
+	H[0] = 0;
+	int score = -1, b_size;
+	for (b_size = 1; b_size <= N; ++b_size) {
+		if (score < -x_dropoff) break;
+		H[b_size] = score--;
+		set_packed_script(state_array, b_size, kPackedGapInA);
+	}
+	int states_used = (b_size + 2) / 2;
+	int best_score = 0;
+	int first_b_index = 0;
+
+	const __m128i neg_inf = _mm_set1_epi16(XDROP_NEG_INF);
+	const __m128i fill1 = _mm_setr_epi16(XDROP_NEG_INF, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i fill2 = _mm_setr_epi16(XDROP_NEG_INF, XDROP_NEG_INF, 0, 0, 0, 0, 0, 0);
+	const __m128i fill4 = _mm_setr_epi16(XDROP_NEG_INF, XDROP_NEG_INF, XDROP_NEG_INF, XDROP_NEG_INF, 0, 0, 0, 0);
+	const __m128i lane_index = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m128i lane_gap = _mm_setr_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i two = _mm_set1_epi16(2);
+	const __m128i four = _mm_set1_epi16(4);
+	const __m128i eight = _mm_set1_epi16(8);
+	const __m128i vx = _mm_set1_epi16(x_dropoff);
+	const __m128i low_byte = _mm_set1_epi32(0xff);
+
+	for (int a_index = 1; a_index <= M; ++a_index) {
+		const __m128i va = _mm_set1_epi16(extract_char<u8>(A, a_index - 1, forward));
+		const int row_first = first_b_index;
+		u8* srow = state_array + states_used;
+		edit_script[a_index] = srow;
+		edit_start_offset[a_index] = row_first;
+		// the first cell of a row has no diagonal predecessor
+		H[row_first - 1] = XDROP_NEG_INF;
+
+		int first_kept = -1, last_kept = -1;
+		int carry_s = XDROP_NEG_INF, carry_p = best_score;
+		__m128i row_max = neg_inf;
+		int b0;
+		for (b0 = row_first; b0 < b_size; b0 += 8) {
+			const __m128i hd = _mm_loadu_si128((const __m128i*)(H + b0 - 1));
+			const __m128i hu = _mm_loadu_si128((const __m128i*)(H + b0));
+			const __m128i bc = _mm_loadu_si128((const __m128i*)(Bc + b0));
+			const __m128i sub = _mm_sub_epi16(_mm_and_si128(_mm_cmpeq_epi16(bc, va), two), one);
+			const __m128i diag = _mm_adds_epi16(hd, sub);
+			const __m128i up = _mm_subs_epi16(hu, one);
+			const __m128i valid = _mm_cmpgt_epi16(_mm_set1_epi16(b_size - b0), lane_index);
+			const __m128i t = _mm_max_epi16(diag, up);
+
+			// gaps along the row
+			__m128i s = _mm_or_si128(_mm_and_si128(valid, t), _mm_andnot_si128(valid, neg_inf));
+			s = _mm_max_epi16(s, _mm_subs_epi16(SHIFT_LANES(s, 1, fill1), one));
+			s = _mm_max_epi16(s, _mm_subs_epi16(SHIFT_LANES(s, 2, fill2), two));
+			s = _mm_max_epi16(s, _mm_subs_epi16(SHIFT_LANES(s, 4, fill4), four));
+			s = _mm_max_epi16(s, _mm_subs_epi16(_mm_set1_epi16(carry_s), lane_gap));
+			const __m128i left = _mm_subs_epi16(_mm_or_si128(_mm_slli_si128(s, 2), _mm_cvtsi32_si128(carry_s & 0xffff)), one);
+			s = _mm_or_si128(_mm_and_si128(valid, s), _mm_andnot_si128(valid, neg_inf));
+
+			// best score up to and including each cell
+			__m128i p = _mm_max_epi16(s, SHIFT_LANES(s, 1, fill1));
+			p = _mm_max_epi16(p, SHIFT_LANES(p, 2, fill2));
+			p = _mm_max_epi16(p, SHIFT_LANES(p, 4, fill4));
+			p = _mm_max_epi16(p, _mm_set1_epi16(carry_p));
+
+			const __m128i kept = _mm_andnot_si128(_mm_cmpgt_epi16(_mm_subs_epi16(p, s), vx), valid);
+			const __m128i snew = _mm_or_si128(_mm_and_si128(kept, s), _mm_andnot_si128(kept, neg_inf));
+			_mm_storeu_si128((__m128i*)(S + b0), snew);
+			row_max = _mm_max_epi16(row_max, snew);
+
+			const __m128i gap_a = _mm_cmpgt_epi16(left, t);
+			const __m128i gap_b = _mm_andnot_si128(gap_a, _mm_cmpgt_epi16(up, diag));
+			__m128i code = _mm_or_si128(_mm_and_si128(gap_a, one), _mm_and_si128(gap_b, two));
+			code = _mm_or_si128(code, _mm_and_si128(_mm_and_si128(kept, _mm_cmpeq_epi16(up, s)), four));
+			code = _mm_or_si128(code, _mm_and_si128(_mm_and_si128(kept, _mm_cmpeq_epi16(left, s)), eight));
+			code = _mm_and_si128(_mm_or_si128(code, _mm_srli_epi32(code, 12)), low_byte);
+			code = _mm_packs_epi32(code, code);
+			code = _mm_packus_epi16(code, code);
+			const int packed = _mm_cvtsi128_si32(code);
+			memcpy(srow + ((b0 - row_first) >> 1), &packed, 4);
+
+			const int mask = _mm_movemask_epi8(kept);
+			if (mask) {
+				if (first_kept < 0) first_kept = b0 + (__builtin_ctz(mask) >> 1);
+				last_kept = b0 + ((31 - __builtin_clz(mask)) >> 1);
+			}
+			carry_s = (i2_t)_mm_extract_epi16(s, 7);
+			carry_p = (i2_t)_mm_extract_epi16(p, 7);
+		}
+
+		if (first_kept < 0) break;
+
+		row_max = _mm_max_epi16(row_max, _mm_srli_si128(row_max, 8));
+		row_max = _mm_max_epi16(row_max, _mm_srli_si128(row_max, 4));
+		row_max = _mm_max_epi16(row_max, _mm_srli_si128(row_max, 2));
+		const int rbest = (i2_t)_mm_cvtsi128_si32(row_max);
+		if (rbest > best_score) {
+			best_score = rbest;
+			ae = a_index;
+			for (be = first_kept; S[be] != rbest; ++be);
+		}
+
+		first_b_index = first_kept;
+		if (last_kept < b_size - 1) {
+			b_size = last_kept + 1;
+		} else {
+			for (int g = S[last_kept] - 1; g >= best_score - x_dropoff && b_size < N; --g, ++b_size) {
+				S[b_size] = g;
+				set_packed_script(srow, b_size - row_first, kPackedGapInA);
+			}
+		}
+		states_used += (max(b0, b_size) - row_first + 2) / 2;
+
+		if (b_size < N) {
+			S[b_size] = XDROP_NEG_INF;
+			++b_size;
+		}
+		swap(H, S);
+	}
+
+	int a_index = ae;
+	int b_index = be;
+	u8 script = SCRIPT_SUB;
+	while (a_index > 0 || b_index > 0) {
+		const u8 next_script = get_packed_script(edit_script[a_index], b_index - edit_start_offset[a_index]);
+		switch (script) {
+			case SCRIPT_GAP_IN_A:
+				script = next_script & SCRIPT_OP_MASK;
+				if (next_script & SCRIPT_EXTEND_GAP_A)
+					script = SCRIPT_GAP_IN_A;
+				break;
+
+			case SCRIPT_GAP_IN_B:
+				script = next_script & SCRIPT_OP_MASK;
+				if (next_script & SCRIPT_EXTEND_GAP_B)
+					script = SCRIPT_GAP_IN_B;
+				break;
+
+			default:
+				script = next_script & SCRIPT_OP_MASK;
+				break;
+		}
+
+		if (script == SCRIPT_GAP_IN_A) {
+			--b_index;
+		} else if (script == SCRIPT_GAP_IN_B) {
+			--a_index;
+		} else {
+			--a_index;
+			--b_index;
+		}
+
+		edit_block->add((EGapAlignOpType)script, 1);
+	}
+
+	return best_score;
+}
+
+#endif // XDROP_SSE2
+
 void
 script_to_aligned_string(const char* query, 
 						 const char* target,
@@ -274,6 +512,7 @@ align_ex(const char* query,
 		 u8** edit_script, 
 		 int* edit_start_offset, 
 		 GapPrelimEditBlock* edit_block,
+		 i2_t* simd_buf,
 		 string& qaln,
 		 string& taln,
 		 bool forward)
@@ -302,7 +541,25 @@ align_ex(const char* query,
 												  qblk,
 												  tblk);
 		
-		int score = xdrop_align(Q, 
+		int score;
+#if XDROP_SSE2
+		if (simd_buf)
+			score = xdrop_align_sse2(Q,
+									 qblk,
+									 T,
+									 tblk,
+									 xap->x_dropoff,
+									 simd_buf,
+									 state_array,
+									 edit_script,
+									 edit_start_offset,
+									 edit_block,
+									 forward,
+									 aln_qe,
+									 aln_te);
+		else
+#endif
+		score = xdrop_align(Q, 
 								qblk, 
 								T, 
 								tblk, 
@@ -356,6 +613,23 @@ align_ex(const char* query,
 	}
 }
 		 
+// the 16-bit kernel covers the default scoring only,
+// MECAT_XDROP_KERNEL=scalar selects the scalar code, e.g. for comparing results
+i2_t*
+new_xdrop_simd_buffer(const XdropAlignParameters& param)
+{
+#if XDROP_SSE2
+	if (param.reward != 1 || param.penalty != -1 || param.gap_open != 0 || param.gap_extend != 1) return NULL;
+	const char* kernel = getenv("MECAT_XDROP_KERNEL");
+	if (kernel && strcmp(kernel, "scalar") == 0) return NULL;
+	i2_t* buf;
+	snew(buf, i2_t, 3 * (param.score_array_size + 2 + 2 * XDROP_SIMD_PAD) + 1);
+	return buf;
+#else
+	return NULL;
+#endif
+}
+
 bool
 XdropAligner::go(const char* query, const int query_start, const int query_size,
 				 const char* target, const int target_start, const int target_size,
@@ -374,6 +648,7 @@ XdropAligner::go(const char* query, const int query_start, const int query_size,
 			 edit_script,
 			 edit_start_offset,
 			 &edit_block,
+			 simd_buf,
 			 left_qaln,
 			 left_taln,
 			 false);
@@ -391,6 +666,7 @@ XdropAligner::go(const char* query, const int query_start, const int query_size,
 			 edit_script,
 			 edit_start_offset,
 			 &edit_block,
+			 simd_buf,
 			 right_qaln,
 			 right_taln,
 			 true);
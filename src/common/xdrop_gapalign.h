@@ -114,6 +114,24 @@ struct XdropAlignParameters
 	}
 };
 
+// the scalar X-drop extension of one block, for any scoring
+int
+xdrop_align(const char* A, const int M, const char* B, const int N, int matrix[][4],
+			int gap_open, int gap_extend, int x_dropoff, u8* state_array, BlastGapDP* score_array,
+			u8** edit_script, int* edit_start_offset, GapPrelimEditBlock* edit_block,
+			const bool forward, int& ae, int& be);
+
+#if defined(__SSE2__)
+// the same for the default scoring, eight cells at a time, with the same results
+int
+xdrop_align_sse2(const char* A, const int M, const char* B, const int N, int x_dropoff, i2_t* simd_buf,
+				 u8* state_array, u8** edit_script, int* edit_start_offset, GapPrelimEditBlock* edit_block,
+				 const bool forward, int& ae, int& be);
+#endif
+
+// NULL if the 16-bit kernel does not apply
+i2_t* new_xdrop_simd_buffer(const XdropAlignParameters& param);
+
 class XdropAligner : public GapAligner
 {
 public:
@@ -128,6 +146,7 @@ public:
 			snew(tbuf, char, param.block_size * 2);
 			snew(qaln, char, MAX_SEQ_SIZE);
 			snew(taln, char, MAX_SEQ_SIZE);
+			simd_buf = new_xdrop_simd_buffer(param);
 		}
 		
 	virtual ~XdropAligner() {
@@ -139,6 +158,7 @@ public:
 		sfree(tbuf);
 		sfree(qaln);
 		sfree(taln);
+		sfree(simd_buf);
 	}
 	
 	void build_score_matrix() {
@@ -209,6 +229,7 @@ public:
 	int						tend;
 	char*					qbuf;
 	char*					tbuf;
+	i2_t*					simd_buf;
 };
 
 #endif // XDROP_GAPALIGN_H
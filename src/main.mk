@@ -8,13 +8,16 @@ endif
 TARGET       := libmecat.a
 
 SOURCES      := common/alignment.cpp \
+		common/bitvec_gapalign.cpp \
 		common/buffer_line_iterator.cpp \
 		common/defs.cpp \
 		common/diff_gapalign.cpp \
 		common/fasta_reader.cpp \
 		common/gapalign.cpp \
 		common/lookup_table.cpp \
+		common/pac_decode.cpp \
 		common/packed_db.cpp \
+		common/record_stream.cpp \
 		common/sequence.cpp \
 		common/split_database.cpp \
 		common/xdrop_gapalign.cpp
@@ -24,4 +27,13 @@ SRC_INCDIRS  := common \
 SUBMAKEFILES := mecat2pw/pw.mk \
 		mecat2ref/mecat2ref.mk \
 		mecat2cns/mecat2cns.mk \
-		filter_reads/filter_reads.mk
+		filter_reads/filter_reads.mk \
+		mecat2m4/mecat2m4.mk \
+		test/xdrop_simd_check.mk \
+		test/bitvec_align_check.mk \
+		test/pac_decode_check.mk
+
+# built and run by 'make check' only
+TEST_TGTS    := xdrop_simd_check \
+		bitvec_align_check \
+		pac_decode_check
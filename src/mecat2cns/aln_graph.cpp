@@ -0,0 +1,362 @@
+#include "aln_graph.h"
+
+#include <cfloat>
+
+namespace ns_meap_cns {
+
+int
+AlnGraph::addNode(const char base, const int weight, const bool backbone, const int bb)
+{
+	if (num_nodes_ == (int)nodes_.size()) nodes_.push_back(Node());
+	Node& node = nodes_[num_nodes_];
+	node.base = base;
+	node.coverage = 0;
+	node.weight = weight;
+	node.bb = bb;
+	node.backbone = backbone;
+	node.in.clear();
+	node.out.clear();
+	return num_nodes_++;
+}
+
+int
+AlnGraph::newEdge(const int u, const int v, const int count, const bool visited)
+{
+	Edge e;
+	e.src = u;
+	e.dst = v;
+	e.count = count;
+	e.visited = visited;
+	edges_.push_back(e);
+	const int id = edges_.size() - 1;
+	nodes_[u].out.push_back(id);
+	nodes_[v].in.push_back(id);
+	return id;
+}
+
+int
+AlnGraph::findEdge(const int u, const int v)
+{
+	const std::vector<int>& out = nodes_[u].out;
+	for (size_t i = 0; i < out.size(); ++i)
+		if (edges_[out[i]].dst == v) return out[i];
+	return -1;
+}
+
+void
+AlnGraph::reset(const int blen)
+{
+	num_nodes_ = 0;
+	edges_.clear();
+	enter_ = addNode('^', 0, true, 0);
+	for (int i = 0; i < blen; ++i) addNode('N', 1, true, i + 1);
+	exit_ = addNode('$', 0, true, 0);
+	for (int i = 0; i <= blen; ++i) newEdge(i, i + 1, 0, false);
+}
+
+void
+AlnGraph::addAln(const std::string& qstr, const std::string& tstr, const int start)
+{
+	const char kGapTag = '-';
+	const size_t alnSize = qstr.size();
+	int bbPos = start;
+	int prevVtx = enter_;
+	for (size_t i = 0; i < alnSize; ++i)
+	{
+		const char queryBase = qstr[i];
+		const char targetBase = tstr[i];
+		if (queryBase == kGapTag && targetBase == kGapTag) continue;
+
+		const int currVtx = bbPos;
+		// match
+		if (queryBase == targetBase)
+		{
+			nodes_[currVtx].coverage++;
+			nodes_[currVtx].base = targetBase;
+			nodes_[currVtx].weight++;
+			addEdge(prevVtx, currVtx);
+			bbPos++;
+			prevVtx = currVtx;
+		}
+		// query deletion
+		else if (queryBase == kGapTag)
+		{
+			nodes_[currVtx].coverage++;
+			nodes_[currVtx].base = targetBase;
+			bbPos++;
+		}
+		// query insertion
+		else if (targetBase == kGapTag)
+		{
+			const int newVtx = addNode(queryBase, 1, false, bbPos);
+			addEdge(prevVtx, newVtx);
+			prevVtx = newVtx;
+		}
+	}
+	addEdge(prevVtx, exit_);
+}
+
+void
+AlnGraph::addEdge(const int u, const int v)
+{
+	const std::vector<int>& in = nodes_[v].in;
+	bool edgeExists = false;
+	for (size_t i = 0; i < in.size(); ++i)
+		if (edges_[in[i]].src == u)
+		{
+			edges_[in[i]].count++;
+			edgeExists = true;
+		}
+	if (!edgeExists) newEdge(u, v, 1, false);
+}
+
+static void
+erase_edge(std::vector<int>& edges, const int e)
+{
+	size_t k = 0;
+	for (size_t i = 0; i < edges.size(); ++i)
+		if (edges[i] != e) edges[k++] = edges[i];
+	edges.resize(k);
+}
+
+// removes all edges of node n, the other edges keep their order
+void
+AlnGraph::clearNode(const int n)
+{
+	Node& node = nodes_[n];
+	for (size_t i = 0; i < node.out.size(); ++i) erase_edge(nodes_[edges_[node.out[i]].dst].in, node.out[i]);
+	for (size_t i = 0; i < node.in.size(); ++i) erase_edge(nodes_[edges_[node.in[i]].src].out, node.in[i]);
+	node.out.clear();
+	node.in.clear();
+}
+
+// appends the neighbours reached through edges that have no other edge on
+// their side to groups_, then sorts them by base, keeping the edge order within a base
+void
+AlnGraph::groupByBase(const std::vector<int>& edges, const bool in, const size_t from)
+{
+	for (size_t i = 0; i < edges.size(); ++i)
+	{
+		const int m = in ? edges_[edges[i]].src : edges_[edges[i]].dst;
+		const size_t degree = in ? nodes_[m].out.size() : nodes_[m].in.size();
+		if (degree == 1) groups_.push_back(m);
+	}
+	for (size_t i = from + 1; i < groups_.size(); ++i)
+	{
+		const int m = groups_[i];
+		size_t j = i;
+		while (j > from && nodes_[groups_[j - 1]].base > nodes_[m].base)
+		{
+			groups_[j] = groups_[j - 1];
+			--j;
+		}
+		groups_[j] = m;
+	}
+}
+
+void
+AlnGraph::mergeInNodes(const int n)
+{
+	const size_t from = groups_.size();
+	groupByBase(nodes_[n].in, true, from);
+	const size_t to = groups_.size();
+	size_t i = from, j;
+	while (i < to)
+	{
+		j = i + 1;
+		while (j < to && nodes_[groups_[j]].base == nodes_[groups_[i]].base) ++j;
+		if (j - i > 1)
+		{
+			const int an = groups_[i];
+			const int anOut = nodes_[an].out[0];
+			for (size_t k = i + 1; k < j; ++k)
+			{
+				const int m = groups_[k];
+				edges_[anOut].count += edges_[nodes_[m].out[0]].count;
+				nodes_[an].weight += nodes_[m].weight;
+			}
+			for (size_t k = i + 1; k < j; ++k)
+			{
+				const int m = groups_[k];
+				for (size_t l = 0; l < nodes_[m].in.size(); ++l)
+				{
+					const int ie = nodes_[m].in[l];
+					const int n1 = edges_[ie].src;
+					const int e = findEdge(n1, an);
+					if (e >= 0) edges_[e].count += edges_[ie].count;
+					else newEdge(n1, an, edges_[ie].count, edges_[ie].visited);
+				}
+				clearNode(m);
+			}
+			mergeInNodes(an);
+		}
+		i = j;
+	}
+	groups_.resize(from);
+}
+
+void
+AlnGraph::mergeOutNodes(const int n)
+{
+	const size_t from = groups_.size();
+	groupByBase(nodes_[n].out, false, from);
+	const size_t to = groups_.size();
+	size_t i = from, j;
+	while (i < to)
+	{
+		j = i + 1;
+		while (j < to && nodes_[groups_[j]].base == nodes_[groups_[i]].base) ++j;
+		if (j - i > 1)
+		{
+			const int an = groups_[i];
+			const int anIn = nodes_[an].in[0];
+			for (size_t k = i + 1; k < j; ++k)
+			{
+				const int m = groups_[k];
+				edges_[anIn].count += edges_[nodes_[m].in[0]].count;
+				nodes_[an].weight += nodes_[m].weight;
+			}
+			for (size_t k = i + 1; k < j; ++k)
+			{
+				const int m = groups_[k];
+				for (size_t l = 0; l < nodes_[m].out.size(); ++l)
+				{
+					const int oe = nodes_[m].out[l];
+					const int n2 = edges_[oe].dst;
+					const int e = findEdge(an, n2);
+					if (e >= 0) edges_[e].count += edges_[oe].count;
+					else newEdge(an, n2, edges_[oe].count, edges_[oe].visited);
+				}
+				clearNode(m);
+			}
+		}
+		i = j;
+	}
+	groups_.resize(from);
+}
+
+void
+AlnGraph::mergeNodes()
+{
+	queue_.clear();
+	queue_.push_back(enter_);
+	size_t head = 0;
+	while (head < queue_.size())
+	{
+		const int u = queue_[head++];
+		mergeInNodes(u);
+		mergeOutNodes(u);
+
+		const std::vector<int>& out = nodes_[u].out;
+		for (size_t i = 0; i < out.size(); ++i)
+		{
+			edges_[out[i]].visited = true;
+			const int v = edges_[out[i]].dst;
+			const std::vector<int>& in = nodes_[v].in;
+			int notVisited = 0;
+			for (size_t k = 0; k < in.size(); ++k)
+				if (!edges_[in[k]].visited) ++notVisited;
+			// move on to the target node after all of its incoming edges are visited
+			if (notVisited == 0) queue_.push_back(v);
+		}
+	}
+}
+
+void
+AlnGraph::bestPath()
+{
+	for (size_t i = 0; i < edges_.size(); ++i) edges_[i].visited = false;
+	score_.assign(num_nodes_, 0.0f);
+	best_edge_.assign(num_nodes_, -1);
+
+	// start at the end and make our way backwards
+	queue_.clear();
+	queue_.push_back(exit_);
+	size_t head = 0;
+	while (head < queue_.size())
+	{
+		const int n = queue_[head++];
+
+		float bestScore = -FLT_MAX;
+		int bestEdge = -1;
+		const std::vector<int>& out = nodes_[n].out;
+		for (size_t i = 0; i < out.size(); ++i)
+		{
+			const Edge& e = edges_[out[i]];
+			const Node& outNode = nodes_[e.dst];
+			float newScore, score = score_[e.dst];
+			if (outNode.backbone && outNode.weight == 1) {
+				newScore = score - 10.0f;
+			} else {
+				newScore = e.count - nodes_[outNode.bb].coverage * 0.5f + score;
+			}
+			if (newScore > bestScore) {
+				bestScore = newScore;
+				bestEdge = out[i];
+			}
+		}
+		if (bestEdge >= 0) {
+			score_[n] = bestScore;
+			best_edge_[n] = bestEdge;
+		}
+
+		const std::vector<int>& in = nodes_[n].in;
+		for (size_t i = 0; i < in.size(); ++i)
+		{
+			edges_[in[i]].visited = true;
+			const int inNode = edges_[in[i]].src;
+			const std::vector<int>& inOut = nodes_[inNode].out;
+			int notVisited = 0;
+			for (size_t k = 0; k < inOut.size(); ++k)
+				if (!edges_[inOut[k]].visited) ++notVisited;
+			if (notVisited == 0) queue_.push_back(inNode);
+		}
+	}
+
+	path_.clear();
+	int prev = enter_;
+	while (true)
+	{
+		path_.push_back(prev);
+		if (best_edge_[prev] < 0) break;
+		prev = edges_[best_edge_[prev]].dst;
+	}
+}
+
+void
+AlnGraph::consensus(const int minWeight, std::string& cns_seq)
+{
+	bestPath();
+
+	// the longest part of the best path where every base meets the minimum weight
+	std::string& cns = cns_seq;
+	cns.clear();
+	int offs = 0, bestOffs = 0, length = 0, idx = 0;
+	bool metWeight = false;
+	for (size_t i = 0; i < path_.size(); ++i)
+	{
+		const Node& n = nodes_[path_[i]];
+		if (n.base == nodes_[enter_].base || n.base == nodes_[exit_].base) continue;
+
+		cns += n.base;
+		if (!metWeight && n.weight >= minWeight) {
+			offs = idx;
+			metWeight = true;
+		} else if (metWeight && n.weight < minWeight) {
+			if ((idx - offs) > length) {
+				bestOffs = offs;
+				length = idx - offs;
+			}
+			metWeight = false;
+		}
+		idx++;
+	}
+	if (metWeight && (idx - offs) > length) {
+		bestOffs = offs;
+		length = idx - offs;
+	}
+	cns.erase(bestOffs + length);
+	cns.erase(0, bestOffs);
+}
+
+} // namespace ns_meap_cns
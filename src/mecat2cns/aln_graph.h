@@ -0,0 +1,68 @@
+#ifndef ALN_GRAPH_H
+#define ALN_GRAPH_H
+
+#include <string>
+#include <vector>
+
+namespace ns_meap_cns {
+
+// The partial order alignment graph used to refine indels, on flat arrays.
+// Nodes and edges are indices into vectors, and the edge lists of a node keep
+// their insertion order, which decides how nodes are merged and how ties on
+// the best path are broken. One graph is kept per thread and reset for every
+// segment, which reuses all of its memory.
+class AlnGraph
+{
+public:
+	AlnGraph() : num_nodes_(0), enter_(0), exit_(0) {}
+	
+	// backbone of blen unknown bases between the enter and exit nodes
+	void reset(const int blen);
+	void addAln(const std::string& qstr, const std::string& tstr, const int start);
+	void mergeNodes();
+	void consensus(const int minWeight, std::string& cns_seq);
+
+private:
+	struct Node
+	{
+		char base;
+		int coverage;
+		int weight;
+		int bb;
+		bool backbone;
+		std::vector<int> in;
+		std::vector<int> out;
+	};
+	struct Edge
+	{
+		int src, dst, count;
+		bool visited;
+	};
+
+	int addNode(const char base, const int weight, const bool backbone, const int bb);
+	int newEdge(const int u, const int v, const int count, const bool visited);
+	int findEdge(const int u, const int v);
+	void addEdge(const int u, const int v);
+	void clearNode(const int n);
+	void groupByBase(const std::vector<int>& edges, const bool in, const size_t from);
+	void mergeInNodes(const int n);
+	void mergeOutNodes(const int n);
+	void bestPath();
+
+private:
+	std::vector<Node> nodes_;
+	int num_nodes_;
+	std::vector<Edge> edges_;
+	int enter_;
+	int exit_;
+	// scratch space, grown as needed and kept between segments
+	std::vector<int> queue_;
+	std::vector<int> groups_;
+	std::vector<float> score_;
+	std::vector<int> best_edge_;
+	std::vector<int> path_;
+};
+
+} // namespace ns_meap_cns
+
+#endif // ALN_GRAPH_H
@@ -0,0 +1,151 @@
+#include "cns_result_writer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+using namespace std;
+
+static bool
+is_gzip_file_name(const char* path)
+{
+	const size_t n = strlen(path);
+	return n > 3 && strcmp(path + n - 3, ".gz") == 0;
+}
+
+CnsResultWriter::CnsResultWriter(const char* path, const int num_threads, const bool ordered)
+	: file_name_(path), out_(NULL), gz_out_(NULL), ordered_(ordered), next_seq_(0), done_(0), closed_(false)
+{
+	if (is_gzip_file_name(path))
+	{
+		gz_out_ = gzopen(path, "wb6");
+		if (!gz_out_) ERROR("failed to open file '%s'", path);
+	}
+	else
+	{
+		out_ = fopen(path, "w");
+		if (!out_) ERROR("failed to open file '%s'", path);
+	}
+	for (int i = 0; i < num_threads; ++i)
+	{
+		rings_.push_back(new CnsOutputRing);
+		blocks_.push_back(new CnsOutputBlock);
+	}
+	pthread_create(&tid_, NULL, writer_func, static_cast<void*>(this));
+}
+
+CnsResultWriter::~CnsResultWriter()
+{
+	close();
+	for (size_t i = 0; i < rings_.size(); ++i)
+	{
+		delete rings_[i];
+		delete blocks_[i];
+	}
+}
+
+void
+CnsResultWriter::add_results(const int tid, vector<CnsResult>& cns_results)
+{
+	string& data = blocks_[tid]->data;
+	char header[128];
+	for (vector<CnsResult>::iterator iter = cns_results.begin(); iter != cns_results.end(); ++iter)
+	{
+		int n = snprintf(header, sizeof(header), ">%lld_%lld_%lld_%lld\n",
+						 (long long)iter->id, (long long)iter->range[0], (long long)iter->range[1], (long long)iter->seq.size());
+		data.append(header, n);
+		data += iter->seq;
+		data += '\n';
+	}
+	cns_results.clear();
+}
+
+void
+CnsResultWriter::end_read(const int tid, const idx_t seq)
+{
+	blocks_[tid]->seq = seq;
+	if (ordered_ || blocks_[tid]->data.size() >= kBlockSize) publish(tid);
+}
+
+void
+CnsResultWriter::flush(const int tid)
+{
+	if (!ordered_ && !blocks_[tid]->data.empty()) publish(tid);
+}
+
+void
+CnsResultWriter::publish(const int tid)
+{
+	// the ring is only full if the disk is far behind, or in ordered mode
+	// if the read to write next is not finished yet, then we have to wait
+	while (!rings_[tid]->push(blocks_[tid])) usleep(1000);
+	blocks_[tid] = new CnsOutputBlock;
+}
+
+void
+CnsResultWriter::write_block(CnsOutputBlock* block)
+{
+	const string& data = block->data;
+	if (!data.empty())
+	{
+		if (gz_out_)
+		{
+			if (gzwrite(gz_out_, data.data(), data.size()) != (int)data.size()) ERROR("failed to write to '%s'", file_name_.c_str());
+		}
+		else if (fwrite(data.data(), 1, data.size(), out_) != data.size())
+		{
+			ERROR("failed to write to '%s'", file_name_.c_str());
+		}
+	}
+	delete block;
+}
+
+void*
+CnsResultWriter::writer_func(void* arg)
+{
+	CnsResultWriter& w = *static_cast<CnsResultWriter*>(arg);
+	while (1)
+	{
+		const int done = __atomic_load_n(&w.done_, __ATOMIC_ACQUIRE);
+		bool got_blocks = false;
+		for (size_t i = 0; i < w.rings_.size(); ++i)
+		{
+			CnsOutputBlock* block;
+			while ((block = w.rings_[i]->front()))
+			{
+				// the blocks of a thread come in read order, so the read to
+				// write next is never behind a block that is held back here
+				if (w.ordered_ && block->seq >= w.next_seq_ + kMaxPendingReads) break;
+				w.rings_[i]->pop();
+				got_blocks = true;
+				if (w.ordered_) w.pending_[block->seq] = block;
+				else w.write_block(block);
+			}
+		}
+		while (!w.pending_.empty() && w.pending_.begin()->first == w.next_seq_)
+		{
+			w.write_block(w.pending_.begin()->second);
+			w.pending_.erase(w.pending_.begin());
+			++w.next_seq_;
+			got_blocks = true;
+		}
+		if (!got_blocks)
+		{
+			if (done) break;
+			usleep(1000);
+		}
+	}
+	return NULL;
+}
+
+void
+CnsResultWriter::close()
+{
+	if (closed_) return;
+	__atomic_store_n(&done_, 1, __ATOMIC_RELEASE);
+	pthread_join(tid_, NULL);
+	closed_ = true;
+	if (!pending_.empty()) ERROR("%d corrected reads are not written, read %lld is missing", (int)pending_.size(), (long long)next_seq_);
+	if (gz_out_ && gzclose(gz_out_) != Z_OK) ERROR("failed to close '%s'", file_name_.c_str());
+	if (out_ && fclose(out_)) ERROR("failed to close '%s'", file_name_.c_str());
+}
@@ -0,0 +1,103 @@
+#ifndef CNS_RESULT_WRITER_H
+#define CNS_RESULT_WRITER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <zlib.h>
+
+#include "../common/alignment.h"
+
+// the FASTA records of corrected reads, formatted by a consensus thread
+struct CnsOutputBlock
+{
+	idx_t seq;
+	std::string data;
+};
+
+// Single producer single consumer queue of blocks, the consensus thread
+// pushes and the writer thread pops, without locks.
+class CnsOutputRing
+{
+public:
+	CnsOutputRing() : head_(0), tail_(0) {}
+	bool push(CnsOutputBlock* block)
+	{
+		const idx_t tail = __atomic_load_n(&tail_, __ATOMIC_RELAXED);
+		if (tail - __atomic_load_n(&head_, __ATOMIC_ACQUIRE) == kRingSize) return false;
+		slots_[tail % kRingSize] = block;
+		__atomic_store_n(&tail_, tail + 1, __ATOMIC_RELEASE);
+		return true;
+	}
+	// the next block to pop, NULL if the ring is empty
+	CnsOutputBlock* front() const
+	{
+		const idx_t head = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+		if (head == __atomic_load_n(&tail_, __ATOMIC_ACQUIRE)) return NULL;
+		return slots_[head % kRingSize];
+	}
+	CnsOutputBlock* pop()
+	{
+		const idx_t head = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+		if (head == __atomic_load_n(&tail_, __ATOMIC_ACQUIRE)) return NULL;
+		CnsOutputBlock* block = slots_[head % kRingSize];
+		__atomic_store_n(&head_, head + 1, __ATOMIC_RELEASE);
+		return block;
+	}
+
+private:
+	static const idx_t kRingSize = 4096;
+	CnsOutputBlock* slots_[kRingSize];
+	idx_t head_;
+	idx_t tail_;
+};
+
+// Writes corrected reads from a dedicated thread. Every consensus thread
+// formats its results into blocks and hands them over through its own ring,
+// so it never waits for the disk. If ordered is set, the reads are written
+// in the order of their sequence numbers (read order within a partition,
+// partitions in order), whatever the number of threads. Then at most
+// kMaxPendingReads reads after the next one to write are taken from the
+// rings, the rest wait there and make their threads wait once the rings
+// are full. Output is gzip compressed if the file name ends with ".gz".
+class CnsResultWriter
+{
+public:
+	CnsResultWriter(const char* path, const int num_threads, const bool ordered);
+	~CnsResultWriter();
+
+	// called by consensus thread tid, seq numbers the reads from 0 without gaps
+	void add_results(const int tid, std::vector<CnsResult>& cns_results);
+	void end_read(const int tid, const idx_t seq);
+	// publishes what thread tid has formatted so far
+	void flush(const int tid);
+
+	// waits for the writer thread to write everything and closes the file
+	void close();
+
+private:
+	void publish(const int tid);
+	void write_block(CnsOutputBlock* block);
+	static void* writer_func(void* arg);
+
+private:
+	static const size_t kBlockSize = 1 << 20;
+	static const idx_t kMaxPendingReads = 4096;
+
+	std::string file_name_;
+	FILE* out_;
+	gzFile gz_out_;
+	bool ordered_;
+	std::vector<CnsOutputRing*> rings_;
+	std::vector<CnsOutputBlock*> blocks_;
+	// blocks that arrived before their turn in ordered mode
+	std::map<idx_t, CnsOutputBlock*> pending_;
+	idx_t next_seq_;
+	int done_;
+	bool closed_;
+	pthread_t tid_;
+};
+
+#endif // CNS_RESULT_WRITER_H
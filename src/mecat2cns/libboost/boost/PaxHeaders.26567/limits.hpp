@@ -1,3 +0,0 @@
-30 mtime=1491398782.377684804
-30 atime=1491398911.707127998
-30 ctime=1491398782.377684804
@@ -1,3 +0,0 @@
-30 mtime=1491398777.125626009
-30 atime=1491398911.683127732
-30 ctime=1491398777.125626009
@@ -1,3 +0,0 @@
-30 mtime=1491398777.345628473
-30 atime=1491398911.639127243
-30 ctime=1491398777.345628473
@@ -1,3 +0,0 @@
-28 mtime=1491398777.2856278
-30 atime=1491398911.639127243
-28 ctime=1491398777.2856278
@@ -1,3 +0,0 @@
-30 mtime=1491398777.317628159
-30 atime=1491398911.643127287
-30 ctime=1491398777.317628159
@@ -1,3 +0,0 @@
-29 mtime=1491398777.30162798
-30 atime=1491398911.643127287
-29 ctime=1491398777.30162798
@@ -1,3 +0,0 @@
-29 mtime=1491398777.94563519
-30 atime=1491398911.719128132
-29 ctime=1491398777.94563519
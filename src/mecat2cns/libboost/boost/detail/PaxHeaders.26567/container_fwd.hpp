@@ -1,3 +0,0 @@
-30 mtime=1491398784.953713637
-30 atime=1491398911.683127732
-30 ctime=1491398784.953713637
@@ -1,3 +0,0 @@
-30 mtime=1491398778.105636981
-30 atime=1491398911.727128221
-30 ctime=1491398778.105636981
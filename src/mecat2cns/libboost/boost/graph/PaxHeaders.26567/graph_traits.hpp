@@ -1,3 +0,0 @@
-30 mtime=1491398778.081636712
-30 atime=1491398911.731128266
-30 ctime=1491398778.081636712
@@ -1,3 +0,0 @@
-29 mtime=1491398780.66566564
-30 atime=1491398911.639127243
-29 ctime=1491398780.66566564
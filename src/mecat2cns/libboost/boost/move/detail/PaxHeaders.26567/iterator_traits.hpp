@@ -1,3 +0,0 @@
-29 mtime=1491398784.89771301
-29 atime=1491398911.65512742
-29 ctime=1491398784.89771301
@@ -1,3 +0,0 @@
-29 mtime=1491398779.50165261
-29 atime=1491398911.73512831
-29 ctime=1491398779.50165261
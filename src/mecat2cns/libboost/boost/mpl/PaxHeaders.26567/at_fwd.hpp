@@ -1,3 +0,0 @@
-30 mtime=1491398780.597664879
-30 atime=1491398911.739128355
-30 ctime=1491398780.597664879
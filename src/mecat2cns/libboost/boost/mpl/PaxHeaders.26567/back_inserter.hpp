@@ -1,3 +0,0 @@
-29 mtime=1491398780.58966479
-30 atime=1491398911.751128488
-29 ctime=1491398780.58966479
@@ -1,3 +0,0 @@
-29 mtime=1491398779.49365252
-30 atime=1491398911.739128355
-29 ctime=1491398779.49365252
@@ -1,3 +0,0 @@
-30 mtime=1491398779.453652072
-30 atime=1491398911.751128488
-30 ctime=1491398779.453652072
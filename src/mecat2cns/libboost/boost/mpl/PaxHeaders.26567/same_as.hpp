@@ -1,3 +0,0 @@
-30 mtime=1491398779.449652027
-30 atime=1491398911.739128355
-30 ctime=1491398779.449652027
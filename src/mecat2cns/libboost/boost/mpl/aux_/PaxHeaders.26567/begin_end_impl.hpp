@@ -1,3 +0,0 @@
-30 mtime=1491398780.285661387
-30 atime=1491398911.743128399
-30 ctime=1491398780.285661387
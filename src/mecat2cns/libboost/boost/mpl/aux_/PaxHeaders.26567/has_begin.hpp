@@ -1,3 +0,0 @@
-28 mtime=1491398780.3136617
-30 atime=1491398911.743128399
-28 ctime=1491398780.3136617
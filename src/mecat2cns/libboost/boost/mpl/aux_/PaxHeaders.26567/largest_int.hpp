@@ -1,3 +0,0 @@
-29 mtime=1491398779.57765346
-30 atime=1491398911.743128399
-29 ctime=1491398779.57765346
@@ -1,3 +0,0 @@
-30 mtime=1491398779.745655342
-30 atime=1491398911.739128355
-30 ctime=1491398779.745655342
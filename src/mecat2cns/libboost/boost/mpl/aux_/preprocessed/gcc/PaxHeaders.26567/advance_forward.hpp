@@ -1,3 +0,0 @@
-30 mtime=1491398780.185660267
-30 atime=1491398911.747128444
-30 ctime=1491398780.185660267
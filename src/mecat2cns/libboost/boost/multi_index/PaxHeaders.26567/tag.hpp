@@ -1,3 +0,0 @@
-28 mtime=1491398780.8496677
-30 atime=1491398911.727128221
-28 ctime=1491398780.8496677
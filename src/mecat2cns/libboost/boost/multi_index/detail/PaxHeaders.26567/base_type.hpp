@@ -1,3 +0,0 @@
-29 mtime=1491398781.03366976
-30 atime=1491398911.727128221
-29 ctime=1491398781.03366976
@@ -1,3 +0,0 @@
-30 mtime=1491398780.925668551
-30 atime=1491398911.727128221
-30 ctime=1491398780.925668551
@@ -1,3 +0,0 @@
-30 mtime=1491398783.973702668
-30 atime=1491398911.711128044
-30 ctime=1491398783.973702668
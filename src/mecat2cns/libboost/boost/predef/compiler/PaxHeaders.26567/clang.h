@@ -1,3 +0,0 @@
-29 mtime=1491398784.20970531
-30 atime=1491398911.711128044
-29 ctime=1491398784.20970531
@@ -1,3 +0,0 @@
-30 mtime=1491398784.297706294
-30 atime=1491398911.711128044
-30 ctime=1491398784.297706294
@@ -1,3 +0,0 @@
-28 mtime=1491398784.3697071
-30 atime=1491398911.715128087
-28 ctime=1491398784.3697071
@@ -1,3 +0,0 @@
-29 mtime=1491398784.72971113
-30 atime=1491398911.715128087
-29 ctime=1491398784.72971113
@@ -1,3 +0,0 @@
-29 mtime=1491398781.46967464
-30 atime=1491398911.683127732
-29 ctime=1491398781.46967464
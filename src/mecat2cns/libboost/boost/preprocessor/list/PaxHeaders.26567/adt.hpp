@@ -1,3 +0,0 @@
-29 mtime=1491398781.56167567
-30 atime=1491398911.671127598
-29 ctime=1491398781.56167567
@@ -1,3 +0,0 @@
-30 mtime=1491398781.161671193
-30 atime=1491398911.679127688
-30 ctime=1491398781.161671193
@@ -1,3 +0,0 @@
-29 mtime=1491398782.01368073
-30 atime=1491398911.675127643
-29 ctime=1491398782.01368073
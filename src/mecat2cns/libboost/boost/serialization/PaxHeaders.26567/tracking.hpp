@@ -1,3 +0,0 @@
-29 mtime=1491398778.49764137
-30 atime=1491398911.687127777
-29 ctime=1491398778.49764137
@@ -1,3 +0,0 @@
-30 mtime=1491398777.865634294
-30 atime=1491398911.715128087
-30 ctime=1491398777.865634294
@@ -1,3 +0,0 @@
-30 mtime=1491398777.877634429
-30 atime=1491398911.715128087
-30 ctime=1491398777.877634429
@@ -1,3 +0,0 @@
-29 mtime=1491398782.71768861
-30 atime=1491398911.659127465
-29 ctime=1491398782.71768861
@@ -1,3 +0,0 @@
-30 mtime=1491398783.317695326
-30 atime=1491398911.695127866
-30 ctime=1491398783.317695326
@@ -1,3 +0,0 @@
-29 mtime=1491398782.88569049
-30 atime=1491398911.699127909
-29 ctime=1491398782.88569049
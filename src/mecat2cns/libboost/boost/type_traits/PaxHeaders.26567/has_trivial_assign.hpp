@@ -1,3 +0,0 @@
-30 mtime=1491398782.961691341
-29 atime=1491398911.69112782
-30 ctime=1491398782.961691341
@@ -1,3 +0,0 @@
-29 mtime=1491398783.50569743
-30 atime=1491398911.703127955
-29 ctime=1491398783.50569743
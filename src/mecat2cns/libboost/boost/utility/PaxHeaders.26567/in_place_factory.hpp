@@ -1,3 +0,0 @@
-29 mtime=1491398780.75766667
-30 atime=1491398911.687127777
-29 ctime=1491398780.75766667
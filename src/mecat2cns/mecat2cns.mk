@@ -7,9 +7,10 @@ endif
 
 TARGET   := mecat2cns
 SOURCES  := main.cpp \
+	aln_graph.cpp \
 	argument.cpp \
+	cns_result_writer.cpp \
 	dw.cpp \
-	MECAT_AlnGraphBoost.C \
 	mecat_correction.cpp \
 	options.cpp \
 	overlaps_partition.cpp \
@@ -17,10 +18,10 @@ SOURCES  := main.cpp \
 	reads_correction_can.cpp \
 	reads_correction_m4.cpp \
 
-SRC_INCDIRS  := . libboost
+SRC_INCDIRS  := .
 
 TGT_LDFLAGS := -L${TARGET_DIR}
-TGT_LDLIBS  := -lmecat
+TGT_LDLIBS  := -lmecat -lz
 TGT_PREREQS := libmecat.a
 
 SUBMAKEFILES :=
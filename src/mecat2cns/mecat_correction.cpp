@@ -1,6 +1,6 @@
 #include "mecat_correction.h"
 
-#include "MECAT_AlnGraphBoost.H"
+#include <set>
 
 using namespace ns_banded_sw;
 
@@ -60,11 +60,11 @@ meap_add_one_aln(const std::string& qaln, const std::string& saln, index_t start
 }
 
 void
-meap_cns_one_indel(const int sb, const int se, CnsAlns& cns_vec, 
+meap_cns_one_indel(const int sb, const int se, CnsAlns& cns_vec, AlnGraph& ag,
 				   const int min_cov, std::string& aux_qstr,
 				   std::string& aux_tstr, std::string& cns)
 {
-	AlnGraphBoost ag(se - sb + 1);
+	ag.reset(se - sb + 1);
 	int sb_out;
 	for (CnsAln* iter = cns_vec.begin(); iter != cns_vec.end(); ++iter)
 	{
@@ -80,7 +80,7 @@ meap_cns_one_indel(const int sb, const int se, CnsAlns& cns_vec,
 void
 meap_consensus_one_segment(CnsTableItem* cns_list, const int cns_list_size, 
 						   uint1* cns_id_vec,
-						   int start_soff, CnsAlns& cns_vec, 
+						   int start_soff, CnsAlns& cns_vec, AlnGraph& ag,
 						   std::string& aux_qstr, std::string& aux_tstr,
 						   std::string& target, const int min_cov)
 {
@@ -100,7 +100,7 @@ meap_consensus_one_segment(CnsTableItem* cns_list, const int cns_list_size,
 			if ((cns_id_vec[k] & UNDS) || (cns_id_vec[k] & FDEL)) { need_refinement = true; break; }
 		if (need_refinement)
 		{
-			meap_cns_one_indel(i + start_soff, j + start_soff, cns_vec, cns_list[i].mat_cnt + cns_list[i].ins_cnt, aux_qstr, aux_tstr, cns);
+			meap_cns_one_indel(i + start_soff, j + start_soff, cns_vec, ag, cns_list[i].mat_cnt + cns_list[i].ins_cnt, aux_qstr, aux_tstr, cns);
 			if (cns.size() > 2) target.append(cns.data() + 1, cns.size() - 2);
 		}
 		i = j;
@@ -206,6 +206,7 @@ void
 consensus_worker(CnsTableItem* cns_table,
 				 uint1* id_list,
 				 CnsAlns& cns_vec,
+				 AlnGraph& ag,
 				 std::string& aux_qstr,
 				 std::string& aux_tstr,
 				 std::vector<MappingRange>& eranges,
@@ -231,7 +232,7 @@ consensus_worker(CnsTableItem* cns_table,
 			if (end - beg >= 0.95 * min_size)
 			{
 				meap_consensus_one_segment(cns_table + beg, end - beg, id_list,
-										   beg, cns_vec, aux_qstr, aux_tstr, cns_seq, min_cov);
+										   beg, cns_vec, ag, aux_qstr, aux_tstr, cns_seq, min_cov);
 				
 				if (cns_seq.size() >= min_size) output_cns_result(cns_results, cns_result, beg, end, cns_seq);
 			}
@@ -299,7 +300,7 @@ consensus_one_read_m4_pacbio(ConsensusThreadData* ctd, const index_t read_id, co
 	cns_vec.get_mapping_ranges(mranges);
 	get_effective_ranges(mranges, eranges, read_size, ctd->rco.min_size);
 
-	consensus_worker(cns_table, ctd->id_list, cns_vec, nqstr, ntstr, eranges, ctd->rco.min_cov, ctd->rco.min_size, read_id,  cns_results);
+	consensus_worker(cns_table, ctd->id_list, cns_vec, ctd->aln_graph, nqstr, ntstr, eranges, ctd->rco.min_cov, ctd->rco.min_size, read_id,  cns_results);
 }
 
 void
@@ -359,7 +360,7 @@ consensus_one_read_m4_nanopore(ConsensusThreadData* ctd, const index_t read_id,
 	std::vector<MappingRange> mranges, eranges;
 	eranges.push_back(MappingRange(0, read_size));
 
-	consensus_worker(cns_table, ctd->id_list, cns_vec, nqstr, ntstr, eranges, ctd->rco.min_cov, ctd->rco.min_size, read_id,  cns_results);
+	consensus_worker(cns_table, ctd->id_list, cns_vec, ctd->aln_graph, nqstr, ntstr, eranges, ctd->rco.min_cov, ctd->rco.min_size, read_id,  cns_results);
 }
 
 struct CmpExtensionCandidateByScore
@@ -449,7 +450,7 @@ consensus_one_read_can_pacbio(ConsensusThreadData* ctd, const index_t read_id, c
 	cns_vec.get_mapping_ranges(mranges);
 	get_effective_ranges(mranges, eranges, read_size, ctd->rco.min_size);
 
-	consensus_worker(cns_table, ctd->id_list, cns_vec, nqstr, ntstr, eranges, ctd->rco.min_cov, ctd->rco.min_size, read_id,  cns_results);
+	consensus_worker(cns_table, ctd->id_list, cns_vec, ctd->aln_graph, nqstr, ntstr, eranges, ctd->rco.min_cov, ctd->rco.min_size, read_id,  cns_results);
 }
 
 void
@@ -511,7 +512,7 @@ consensus_one_read_can_nanopore(ConsensusThreadData* ctd, const index_t read_id,
 	std::vector<MappingRange> mranges, eranges;
 	eranges.push_back(MappingRange(0, read_size));
 
-	consensus_worker(cns_table, ctd->id_list, cns_vec, nqstr, ntstr, eranges, ctd->rco.min_cov, ctd->rco.min_size, read_id,  cns_results);
+	consensus_worker(cns_table, ctd->id_list, cns_vec, ctd->aln_graph, nqstr, ntstr, eranges, ctd->rco.min_cov, ctd->rco.min_size, read_id,  cns_results);
 }
 
 } // namespace ns_meap_cns {
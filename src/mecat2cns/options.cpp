@@ -28,6 +28,8 @@ static bool print_usage_nanopore		= false;
 static int tech_nanopore				= TECH_NANOPORE;
 
 static int default_tech = TECH_PACBIO;
+static bool filter_repeat_reads     = false;
+static bool ordered_output          = true;
 
 static const char input_type_n    = 'i';
 static const char num_threads_n   = 't';
@@ -38,6 +40,8 @@ static const char cov_n           = 'c';
 static const char min_size_n      = 'l';
 static const char usage_n         = 'h';
 static const char tech_n          = 'x';
+static const char filter_repeat_n = 'f';
+static const char ordered_n       = 'd';
 
 void
 print_pacbio_default_options()
@@ -100,6 +104,12 @@ print_usage(const char* prog)
 	
 	cerr << "-" << min_size_n << " <Integer>\t" << "minimum length of corrected sequence" << "\n";
 	
+	cerr << "-" << filter_repeat_n << " <0/1>\t" << "m4 input only: 0 = keep, 1 = skip the overlaps of repeat reads (contained in 100 or more overlaps)" << "\n"
+		 << "\t\t" << "default: " << filter_repeat_reads << "\n";
+	
+	cerr << "-" << ordered_n << " <0/1>\t" << "output order: 0 = as the reads are corrected, 1 = by read id, the same for any number of threads" << "\n"
+		 << "\t\t" << "default: " << ordered_output << "\n";
+	
 	cerr << "-" << usage_n << "\t\t" << "print usage info." << "\n";
 	
 	cerr << "\n"
@@ -128,6 +138,8 @@ init_consensus_options(int tech)
 		t.min_size              = min_size_pacbio;
 		t.print_usage_info      = print_usage_pacbio;
 		t.tech                  = tech_pacbio;
+		t.filter_repeat_reads   = filter_repeat_reads;
+		t.ordered_output        = ordered_output;
 	} else {
 		t.input_type            = input_type_nanopore;
 		t.m4                    = NULL;
@@ -141,6 +153,8 @@ init_consensus_options(int tech)
 		t.min_size              = min_size_nanopore;
 		t.print_usage_info      = print_usage_nanopore;
 		t.tech                  = tech_nanopore;
+		t.filter_repeat_reads   = filter_repeat_reads;
+		t.ordered_output        = ordered_output;
 	}
     return t;
 }
@@ -187,7 +201,7 @@ parse_arguments(int argc, char* argv[], ConsensusOptions& t)
 	int opt_char;
     char err_char;
     opterr = 0;
-	while((opt_char = getopt(argc, argv, "i:t:p:r:a:c:l:x:h")) != -1) {
+	while((opt_char = getopt(argc, argv, "i:t:p:r:a:c:l:x:f:d:h")) != -1) {
 		switch (opt_char) {
 			case input_type_n:
 				if (optarg[0] == '0')
@@ -222,6 +236,12 @@ parse_arguments(int argc, char* argv[], ConsensusOptions& t)
 				break;
 			case tech_n:
 				break;
+			case filter_repeat_n:
+				t.filter_repeat_reads = (atoi(optarg) != 0);
+				break;
+			case ordered_n:
+				t.ordered_output = (atoi(optarg) != 0);
+				break;
 			case '?':
                 err_char = (char)optopt;
 				fprintf(stderr, "unrecognised option '%c'\n", err_char);
@@ -285,4 +305,6 @@ print_options(ConsensusOptions& t)
 	cout << "cov:\t" << t.min_cov << "\n";
 	cout << "min size:\t" << t.min_size << "\n";
 	cout << "tech:\t" << t.tech << "\n";
+	cout << "filter repeat reads:\t" << t.filter_repeat_reads << "\n";
+	cout << "ordered output:\t" << t.ordered_output << "\n";
 }
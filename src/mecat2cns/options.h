@@ -20,6 +20,8 @@ struct ConsensusOptions
     index_t     min_size;
     bool        print_usage_info;
     int         tech;
+    bool        filter_repeat_reads;
+    bool        ordered_output;
 };
 
 void
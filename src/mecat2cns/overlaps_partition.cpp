@@ -7,6 +7,7 @@
 
 #include "overlaps_store.h"
 #include "reads_correction_aux.h"
+#include "../common/record_stream.h"
 
 using namespace std;
 
@@ -38,68 +39,14 @@ subject_is_contained(const M4Record& m4, const double min_cov_ratio)
 	return sm >= ss;
 }
 
-void
-get_qualified_m4record_counts(const char* m4_file_name, const double min_cov_ratio, index_t& num_qualified_records, index_t& num_reads)
-{
-    std::ifstream in;
-    open_fstream(in, m4_file_name, std::ios::in);
-    num_qualified_records = 0;
-    num_reads = -1;
-    index_t num_records = 0;
-    M4Record m4;
-	m4qext(m4) = m4sext(m4) = INVALID_IDX;
-    while (in >> m4)
-    {
-		if (m4qext(m4) == INVALID_IDX || m4sext(m4) == INVALID_IDX)
-		{
-			ERROR("no gapped start position is provided, please make sure that you have run \'meap_pairwise\' with option \'-g 1\'");
-		}
-        ++num_records;
-        if (check_m4record_mapping_range(m4, min_cov_ratio)) ++num_qualified_records;
-        num_reads = std::max(num_reads, m4qid(m4));
-        num_reads = std::max(num_reads, m4sid(m4));
-    }
-    close_fstream(in);
+// reads contained in this many overlaps are taken as repeats
+static const char kRepeatContainedCount = 100;
 
-	LOG(stderr, "there are %d overlaps, %d are qualified.", (int)num_records, (int)num_qualified_records);
-    ++num_reads;
-}
-
-void
-get_repeat_reads(const char* m4_file_name, const double min_cov_ratio, const index_t num_reads, set<index_t>& repeat_reads)
+static inline void
+count_contained(vector<char>& cnts, const index_t id)
 {
-	const char MaxContained = 100;
-	char cnt_table[MaxContained + 1];
-	for (int i = 0; i < MaxContained; ++i) cnt_table[i] = i + 1;
-	cnt_table[MaxContained] = MaxContained;
-	vector<char> cnts(num_reads, 0);
-	std::ifstream in;
-    open_fstream(in, m4_file_name, std::ios::in);
-	M4Record m4;
-	m4qext(m4) = m4sext(m4) = INVALID_IDX;
-    while (in >> m4)
-    {
-		if (query_is_contained(m4, min_cov_ratio))
-		{
-			index_t qid = m4qid(m4);
-			cnts[qid] = cnt_table[cnts[qid]];
-		}
-		if (subject_is_contained(m4, min_cov_ratio))
-		{
-			index_t sid = m4sid(m4);
-			cnts[sid] = cnt_table[cnts[sid]];
-		}
-    }
-    close_fstream(in);
-	
-	for(index_t i = 0; i < num_reads; ++i)
-		if (cnts[i] >= MaxContained) 
-		{
-			cerr << "repeat read " << i << "\n";
-			repeat_reads.insert(i);
-		}
-
-	LOG(stderr, "number of repeat reads: %d", (int)repeat_reads.size());
+	if (id >= (index_t)cnts.size()) cnts.resize(std::max<index_t>(id + 1, 2 * cnts.size()), 0);
+	if (cnts[id] < kRepeatContainedCount) ++cnts[id];
 }
 
 void 
@@ -119,22 +66,6 @@ generate_partition_file_name(const char* m4_file_name, const index_t part, std::
     ret += os.str();
 }
 
-idx_t
-get_num_reads(const char* candidates_file)
-{
-	ifstream in;
-	open_fstream(in, candidates_file, ios::in);
-	ExtensionCandidate ec;
-	int max_id = -1;
-	while (in >> ec)
-	{
-		max_id = std::max(ec.qid, max_id);
-		max_id = std::max(ec.sid, max_id);
-	}
-	close_fstream(in);
-	return max_id + 1;
-}
-
 void
 normalise_candidate(ExtensionCandidate& src, ExtensionCandidate& dst, const bool subject_is_target)
 {
@@ -162,118 +93,125 @@ normalise_candidate(ExtensionCandidate& src, ExtensionCandidate& dst, const bool
 	}
 }
 
+#define PROGRESS_INTERVAL (1 << 22)
+
+static void
+report_partition_progress(OverlapRecordReader& reader, const idx_t num_records, Timer& timer)
+{
+	timer.stop();
+	const double mb = reader.bytes_read() / 1048576.0;
+	const double total_mb = reader.file_size() / 1048576.0;
+	const double secs = timer.elapsed();
+	LOG(stderr, "%lld records, %.1f of %.1f MB (%.1f%%) are partitioned, %.1f MB/s",
+		(long long)num_records, mb, total_mb, total_mb > 0 ? 100.0 * mb / total_mb : 100.0, secs > 0 ? mb / secs : 0.0);
+}
+
+static void
+write_partition_index(const char* input, PartitionResultsWriter<ExtensionCandidate>& prw)
+{
+	std::string idx_file_name;
+	generate_partition_index_file_name(input, idx_file_name);
+	std::ofstream idx_file;
+	open_fstream(idx_file, idx_file_name.c_str(), std::ios::out);
+	for (idx_t i = 0; i < prw.NumPartitions(); ++i)
+	{
+		const PartitionResultsWriter<ExtensionCandidate>::Partition* p = prw.GetPartition(i);
+		if (!p) continue;
+		idx_file << p->file_name << "\t" << p->min_seq_id << "\t" << p->max_seq_id << "\n";
+		fprintf(stderr, "%s contains reads %d --- %d\n", p->file_name.c_str(), (int)p->min_seq_id, (int)p->max_seq_id);
+	}
+	close_fstream(idx_file);
+	LOG(stderr, "%d partitions, %d early buffer spills", (int)prw.NumPartitions(), (int)prw.NumSpills());
+}
+
 void
 partition_candidates(const char* input, const idx_t batch_size, const int min_read_size)
 {
 	DynamicTimer dtimer(__func__);
 	
-	idx_t num_reads = get_num_reads(input);
-	const index_t num_batches = (num_reads + batch_size - 1) / batch_size;
-	std::string idx_file_name;
-    generate_partition_index_file_name(input, idx_file_name);
-    std::ofstream idx_file;
-    open_fstream(idx_file, idx_file_name.c_str(), std::ios::out);
-	
+	OverlapRecordReader reader(input);
+	PartitionResultsWriter<ExtensionCandidate> prw(input, generate_partition_file_name, batch_size);
 	ExtensionCandidate ec, nec;
-	PartitionResultsWriter<ExtensionCandidate> prw;
-	for (index_t i = 0; i < num_batches; i += PartitionResultsWriter<ExtensionCandidate>::kNumFiles)
+	idx_t num_records = 0;
+	Timer timer;
+	timer.go();
+	while (reader.next(ec))
 	{
-		const index_t sfid = i;
-        const index_t efid = std::min(sfid + PartitionResultsWriter<ExtensionCandidate>::kNumFiles, num_batches);
-        const int nf = efid - sfid;
-        const index_t L = batch_size * sfid;
-        const index_t R = batch_size * efid;
-        std::ifstream in;
-        open_fstream(in, input, std::ios::in);
-		prw.OpenFiles(sfid, efid, input, generate_partition_file_name);
-		
-		while (in >> ec)
-		{
-			if (ec.qsize < min_read_size || ec.ssize < min_read_size) continue;
-			if (ec.qid >= L && ec.qid < R)
-			{
-				normalise_candidate(ec, nec, false);
-				prw.WriteOneResult((ec.qid - L) / batch_size, ec.qid, nec);
-			}
-			if (ec.sid >= L && ec.sid < R)
-			{
-				normalise_candidate(ec, nec, true);
-				prw.WriteOneResult((ec.sid - L) / batch_size, ec.sid, nec);
-			}
-		}
-		
-		for (int k = 0; k < nf; ++k)
-        {
-            if (prw.max_seq_ids[k] == std::numeric_limits<index_t>::min()) continue;
-            idx_file << prw.file_names[k] << "\t" << prw.min_seq_ids[k] << "\t" << prw.max_seq_ids[k] << "\n";
-			fprintf(stderr, "%s contains reads %d --- %d\n", prw.file_names[k].c_str(), (int)prw.min_seq_ids[k], (int)prw.max_seq_ids[k]);
-        }
+		if (++num_records % PROGRESS_INTERVAL == 0) report_partition_progress(reader, num_records, timer);
+		if (ec.qsize < min_read_size || ec.ssize < min_read_size) continue;
+		normalise_candidate(ec, nec, false);
+		prw.WriteOneResult(ec.qid, nec);
+		normalise_candidate(ec, nec, true);
+		prw.WriteOneResult(ec.sid, nec);
 	}
-    prw.CloseFiles();
-	close_fstream(idx_file);
+	prw.Close();
+	report_partition_progress(reader, num_records, timer);
+	write_partition_index(input, prw);
 }
 
 void
-partition_m4records(const char* m4_file_name, const double min_cov_ratio, const index_t batch_size, const int min_read_size)
+partition_m4records(const char* m4_file_name, const double min_cov_ratio, const index_t batch_size, const int min_read_size, vector<char>& repeat_reads)
 {
 	DynamicTimer dtimer(__func__);
 	
-    index_t num_reads, num_qualified_records;
-    get_qualified_m4record_counts(m4_file_name, min_cov_ratio, num_qualified_records, num_reads);
-	set<index_t> repeat_reads;
-	//get_repeat_reads(m4_file_name, min_cov_ratio, num_reads, repeat_reads);
-    const index_t num_batches = (num_reads + batch_size - 1) / batch_size;
-    std::string idx_file_name;
-    generate_partition_index_file_name(m4_file_name, idx_file_name);
-    std::ofstream idx_file;
-    open_fstream(idx_file, idx_file_name.c_str(), std::ios::out);
-
-    M4Record m4, nm4;
+	OverlapRecordReader reader(m4_file_name);
+	PartitionResultsWriter<ExtensionCandidate> prw(m4_file_name, generate_partition_file_name, batch_size);
+	vector<char> contained_cnts;
+	M4Record m4, nm4;
 	ExtensionCandidate ec;
-    PartitionResultsWriter<ExtensionCandidate> prw;
-    for (index_t i = 0; i < num_batches; i += PartitionResultsWriter<ExtensionCandidate>::kNumFiles)
-    {
-        const index_t sfid = i;
-        const index_t efid = std::min(sfid + PartitionResultsWriter<ExtensionCandidate>::kNumFiles, num_batches);
-        const int nf = efid - sfid;
-        const index_t L = batch_size * sfid;
-        const index_t R = batch_size * efid;
-        std::ifstream in;
-        open_fstream(in, m4_file_name, std::ios::in);
-		prw.OpenFiles(sfid, efid, m4_file_name, generate_partition_file_name);
-
-        while (in >> m4)
-        {
-			if (m4qsize(m4) < min_read_size || m4ssize(m4) < min_read_size) continue;
-            if (!check_m4record_mapping_range(m4, min_cov_ratio)) continue;
-			if (repeat_reads.find(m4qid(m4)) != repeat_reads.end()
-				||
-				repeat_reads.find(m4sid(m4)) != repeat_reads.end()) continue;
-			
-            if (m4qid(m4) >= L && m4qid(m4) < R)
-            {
-                normalize_m4record(m4, false, nm4);
-				m4_to_candidate(nm4, ec);
-                prw.WriteOneResult((m4qid(m4) - L) / batch_size, m4qid(m4), ec);
-            }
-            if (m4sid(m4) >= L && m4sid(m4) < R)
-            {
-                normalize_m4record(m4, true, nm4);
-				m4_to_candidate(nm4, ec);
-                prw.WriteOneResult((m4sid(m4) - L) / batch_size, m4sid(m4), ec);
-            }
-        }
-
-        for (int k = 0; k < nf; ++k)
-        {
-            if (prw.max_seq_ids[k] == std::numeric_limits<index_t>::min()) continue;
-            idx_file << prw.file_names[k] << "\t" << prw.min_seq_ids[k] << "\t" << prw.max_seq_ids[k] << "\n";
-			fprintf(stderr, "%s contains reads %d --- %d\n", prw.file_names[k].c_str(), (int)prw.min_seq_ids[k], (int)prw.max_seq_ids[k]);
-        }
+	idx_t num_records = 0, num_qualified_records = 0;
+	Timer timer;
+	timer.go();
+	while (reader.next(m4))
+	{
+		if (m4qext(m4) == INVALID_IDX || m4sext(m4) == INVALID_IDX)
+		{
+			ERROR("no gapped start position is provided, please make sure that you have run \'meap_pairwise\' with option \'-g 1\'");
+		}
+		if (++num_records % PROGRESS_INTERVAL == 0) report_partition_progress(reader, num_records, timer);
+		if (query_is_contained(m4, min_cov_ratio)) count_contained(contained_cnts, m4qid(m4));
+		if (subject_is_contained(m4, min_cov_ratio)) count_contained(contained_cnts, m4sid(m4));
+		
+		if (!check_m4record_mapping_range(m4, min_cov_ratio)) continue;
+		++num_qualified_records;
+		if (m4qsize(m4) < min_read_size || m4ssize(m4) < min_read_size) continue;
+		
+		normalize_m4record(m4, false, nm4);
+		m4_to_candidate(nm4, ec);
+		prw.WriteOneResult(m4qid(m4), ec);
+		normalize_m4record(m4, true, nm4);
+		m4_to_candidate(nm4, ec);
+		prw.WriteOneResult(m4sid(m4), ec);
+	}
+	prw.Close();
+	report_partition_progress(reader, num_records, timer);
+	LOG(stderr, "there are %d overlaps, %d are qualified.", (int)num_records, (int)num_qualified_records);
+	write_partition_index(m4_file_name, prw);
+	
+	// repeats are only known after the whole file is read, they are dropped when a partition is loaded
+	repeat_reads.assign(contained_cnts.size(), 0);
+	int num_repeat_reads = 0;
+	for (size_t i = 0; i < contained_cnts.size(); ++i)
+		if (contained_cnts[i] >= kRepeatContainedCount)
+		{
+			repeat_reads[i] = 1;
+			++num_repeat_reads;
+		}
+	LOG(stderr, "number of repeat reads: %d", num_repeat_reads);
+}
 
-        prw.CloseFiles();
-    }
-    close_fstream(idx_file);
+idx_t
+remove_repeat_read_overlaps(ExtensionCandidate* ec_list, const idx_t nec, const vector<char>& repeat_reads)
+{
+	const idx_t n = repeat_reads.size();
+	idx_t k = 0;
+	for (idx_t i = 0; i < nec; ++i)
+	{
+		const ExtensionCandidate& ec = ec_list[i];
+		if ((ec.qid < n && repeat_reads[ec.qid]) || (ec.sid < n && repeat_reads[ec.sid])) continue;
+		ec_list[k++] = ec;
+	}
+	return k;
 }
 
 void
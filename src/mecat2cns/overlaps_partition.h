@@ -12,7 +12,11 @@ void
 generate_partition_file_name(const char* m4_file_name, const index_t part, std::string& ret);
 
 void
-partition_m4records(const char* m4_file_name, const double min_cov_ratio, const index_t batch_size, const int min_read_size);
+partition_m4records(const char* m4_file_name, const double min_cov_ratio, const index_t batch_size, const int min_read_size, std::vector<char>& repeat_reads);
+
+// drops the overlaps of repeat reads, returns the number of overlaps left
+idx_t
+remove_repeat_read_overlaps(ExtensionCandidate* ec_list, const idx_t nec, const std::vector<char>& repeat_reads);
 
 void
 partition_candidates(const char* input, const idx_t batch_size, const int min_read_size);
@@ -4,86 +4,121 @@
 #include <fstream>
 #include <limits>
 #include <string>
+#include <vector>
 
 #include "../common/defs.h"
 #include "../common/pod_darr.h"
 
+// Results are routed to partition seq_id / batch_size, there is no limit on the
+// number of partitions. Every partition has a buffer in memory, when the buffers
+// together have room for kMaxBufferedResults results the largest ones are appended
+// to their files and freed.
 template <class T>
 class PartitionResultsWriter
 {
 public:
 	typedef void (*file_name_generator)(const char* prefix, const idx_t id, std::string& name);
 	
+	struct Partition
+	{
+		// NULL while nothing is buffered
+		PODArray<T>* results;
+		std::string file_name;
+		bool file_created;
+		idx_t min_seq_id;
+		idx_t max_seq_id;
+	};
+	
 public:
-	PartitionResultsWriter()
+	PartitionResultsWriter(const std::string& prefix, file_name_generator fng, const idx_t batch_size)
+		: prefix_(prefix), fng_(fng), batch_size_(batch_size), num_allocated_(0), num_spills_(0)
 	{
-		file_is_open = false;
-		num_open_files = false;
-		for (int i = 0; i < num_open_files; ++i) results[i].reserve(kStoreSize);
 	}
 	~PartitionResultsWriter()
 	{
-		
-	}
-	void OpenFiles(const idx_t sfid, const idx_t efid, const std::string& prefix, file_name_generator fng)
-	{
-		if (file_is_open) CloseFiles();
-		
-		const int nf = efid - sfid;
-        if (nf == 0) return;
-        for (int i = 0; i < nf; ++i)
-        {
-            fng(prefix.data(), i + sfid, file_names[i]);
-            open_fstream(files[i], file_names[i].c_str(), std::ios::binary);
-            min_seq_ids[i] = std::numeric_limits<index_t>::max();
-            max_seq_ids[i] = std::numeric_limits<index_t>::min();
-			results[i].clear();
-        }
-        num_open_files = nf;
-        file_is_open = true;
+		for (size_t i = 0; i < partitions_.size(); ++i)
+			if (partitions_[i])
+			{
+				delete partitions_[i]->results;
+				delete partitions_[i];
+			}
 	}
-	void CloseFiles()
+	void WriteOneResult(const idx_t seq_id, const T& r)
 	{
-		if (!file_is_open) return;
-		for (int i = 0; i < num_open_files; ++i)
+		const idx_t pid = seq_id / batch_size_;
+		if (pid >= (idx_t)partitions_.size()) partitions_.resize(pid + 1, NULL);
+		Partition* p = partitions_[pid];
+		if (!p)
 		{
-			if (results[i].size())
-			{
-				char* buf = (char*)results[i].data();
-				std::streamsize s = sizeof(T) * results[i].size();
-				files[i].write(buf, s);
-			}
+			p = new Partition;
+			p->results = NULL;
+			fng_(prefix_.data(), pid, p->file_name);
+			p->file_created = false;
+			p->min_seq_id = std::numeric_limits<idx_t>::max();
+			p->max_seq_id = std::numeric_limits<idx_t>::min();
+			partitions_[pid] = p;
 		}
-        for (int i = 0; i < num_open_files; ++i) close_fstream(files[i]);
-        file_is_open = false;
-        num_open_files = 0;
+		p->min_seq_id = std::min(p->min_seq_id, seq_id);
+		p->max_seq_id = std::max(p->max_seq_id, seq_id);
+		if (!p->results)
+		{
+			p->results = new PODArray<T>;
+			num_allocated_ += p->results->capacity();
+		}
+		const idx_t capacity = p->results->capacity();
+		p->results->push_back(r);
+		num_allocated_ += p->results->capacity() - capacity;
+		while (num_allocated_ >= kMaxBufferedResults) SpillLargest();
 	}
-	void WriteOneResult(const int fid, const idx_t seq_id, const T& r)
+	// writes out the buffers, partitions without results are NULL
+	void Close()
 	{
-		r_assert(fid < num_open_files);
-		min_seq_ids[fid] = std::min(min_seq_ids[fid], seq_id);
-        max_seq_ids[fid] = std::max(max_seq_ids[fid], seq_id);
-		results[fid].push_back(r);
-		if (results[fid].size() == kStoreSize)
+		for (size_t i = 0; i < partitions_.size(); ++i)
+			if (partitions_[i]) Spill(partitions_[i]);
+	}
+	idx_t NumPartitions() const { return partitions_.size(); }
+	const Partition* GetPartition(const idx_t pid) const { return partitions_[pid]; }
+	// number of buffers written out before Close()
+	idx_t NumSpills() const { return num_spills_; }
+	
+private:
+	void Spill(Partition* p)
+	{
+		std::ofstream file;
+		if (p->file_created) open_fstream(file, p->file_name.c_str(), std::ios::binary | std::ios::app);
+		else open_fstream(file, p->file_name.c_str(), std::ios::binary | std::ios::trunc);
+		p->file_created = true;
+		if (p->results)
 		{
-			char* buf = (char*)results[fid].data();
-			std::streamsize s = sizeof(T) * results[fid].size();
-			files[fid].write(buf, s);
-			results[fid].clear();
+			file.write((const char*)p->results->data(), sizeof(T) * p->results->size());
+			num_allocated_ -= p->results->capacity();
+			delete p->results;
+			p->results = NULL;
 		}
+		close_fstream(file);
+	}
+	// spills the partition holding the largest buffer
+	void SpillLargest()
+	{
+		Partition* largest = NULL;
+		for (size_t i = 0; i < partitions_.size(); ++i)
+			if (partitions_[i] && partitions_[i]->results 
+				&& (!largest || partitions_[i]->results->capacity() > largest->results->capacity())) largest = partitions_[i];
+		Spill(largest);
+		++num_spills_;
 	}
 	
 public:
-	static const int kNumFiles = 10;
-	static const int kStoreSize = 500000;
+	// counts the room allocated for results, not the results buffered
+	static const idx_t kMaxBufferedResults = 5000000;
 	
-	PODArray<T> results[kNumFiles];
-	bool file_is_open;
-    int num_open_files;
-	std::ofstream files[kNumFiles];
-    std::string file_names[kNumFiles];
-	idx_t min_seq_ids[kNumFiles];
-	idx_t max_seq_ids[kNumFiles];
+private:
+	std::string prefix_;
+	file_name_generator fng_;
+	idx_t batch_size_;
+	std::vector<Partition*> partitions_;
+	idx_t num_allocated_;
+	idx_t num_spills_;
 };
 
 template <class T>
@@ -1,5 +1,10 @@
 #include "reads_correction_aux.h"
 
+#include <algorithm>
+
+#include "overlaps_partition.h"
+#include "overlaps_store.h"
+
 void normalize_gaps(const char* qstr, const char* tstr, const index_t aln_size, std::string& qnorm, std::string& tnorm, const bool push)
 {
     qnorm.clear();
@@ -86,30 +91,71 @@ struct CmpExtensionCandidateBySid
 	}
 };
 
-void
-build_cns_thrd_data_can(ExtensionCandidate* ec_list, 
-						const int nec,
-						const idx_t min_rid,
-						const idx_t max_rid,
-						ReadsCorrectionOptions* prco,
-						PackedDB* reads,
-						std::ostream* out,
-					    ConsensusThreadData** ppctd)
+void*
+CnsPartitionLoader::load_func(void* arg)
 {
-	const index_t num_reads = max_rid - min_rid + 1;
-	const int num_threads = prco->num_threads;
-    const index_t num_reads_per_thread = (num_reads + num_threads - 1) / num_threads;
+	CnsPartitionLoader* loader = static_cast<CnsPartitionLoader*>(arg);
+	CnsPartition* partition = loader->partition_;
+	Timer timer;
+	timer.go();
+	partition->ec_list = load_partition_data<ExtensionCandidate>(partition->file_name.c_str(), partition->num_ec);
+	if (loader->repeat_reads_) 
+		partition->num_ec = remove_repeat_read_overlaps(partition->ec_list, partition->num_ec, *loader->repeat_reads_);
+	ExtensionCandidate* ec_list = partition->ec_list;
+	const idx_t nec = partition->num_ec;
 	std::sort(ec_list, ec_list + nec, CmpExtensionCandidateBySid());
-	idx_t max_id = min_rid;
-	idx_t i = 0, j;
-	int tid = 0;
-	while (i < nec)
+	for (idx_t i = 0; i < nec; ++i)
+		if (i == 0 || ec_list[i].sid != ec_list[i - 1].sid) partition->read_starts.push_back(i);
+	partition->read_starts.push_back(nec);
+	timer.stop();
+	partition->load_time = timer.elapsed();
+	return NULL;
+}
+
+void
+CnsPartitionLoader::start(const char* file_name)
+{
+	r_assert(!running_ && !partition_);
+	partition_ = new CnsPartition;
+	partition_->file_name = file_name;
+	pthread_create(&tid_, NULL, load_func, static_cast<void*>(this));
+	running_ = true;
+}
+
+CnsPartition*
+CnsPartitionLoader::wait()
+{
+	if (!running_) return NULL;
+	Timer timer;
+	timer.go();
+	pthread_join(tid_, NULL);
+	timer.stop();
+	running_ = false;
+	CnsPartition* partition = partition_;
+	partition_ = NULL;
+	partition->stall_time = timer.elapsed();
+	++num_loaded_;
+	load_time_ += partition->load_time;
+	stall_time_ += partition->stall_time;
+	return partition;
+}
+
+void
+CnsPartitionLoader::report()
+{
+	LOG(stderr, "%d partitions loaded in %.2f secs, %.2f secs of which were hidden behind consensus", 
+		num_loaded_, load_time_, std::max(load_time_ - stall_time_, 0.0));
+}
+
+void
+report_cns_partition(CnsPartition* partition, ConsensusThreadData** pctds, const int num_threads)
+{
+	double min_time = pctds[0]->busy_time, max_time = pctds[0]->busy_time;
+	for (int i = 0; i < num_threads; ++i)
 	{
-		max_id += num_reads_per_thread;
-		j = i + 1;
-		while (j < nec && ec_list[j].sid < max_id) ++j;
-		ppctd[tid] = new ConsensusThreadData(prco, tid, reads, ec_list + i, j - i, out);
-		++tid;
-		i = j;
+		min_time = std::min(min_time, pctds[i]->busy_time);
+		max_time = std::max(max_time, pctds[i]->busy_time);
 	}
+	LOG(stderr, "%s: %d reads, loaded in %.2f secs (waited %.2f secs), threads finished in %.2f -- %.2f secs", 
+		partition->file_name.c_str(), (int)partition->num_reads(), partition->load_time, partition->stall_time, min_time, max_time);
 }
@@ -4,9 +4,11 @@
 #include <vector>
 #include <cstring>
 
+#include "aln_graph.h"
 #include "dw.h"
 #include "../common/packed_db.h"
 #include "options.h"
+#include "cns_result_writer.h"
 
 struct CnsTableItem
 {
@@ -41,8 +43,9 @@ struct MappingRange
 struct CnsAln
 {
 	int soff, send, aln_idx, aln_size;
-	char qaln[MAX_SEQ_SIZE];
-	char saln[MAX_SEQ_SIZE];
+	// both strings live in the arena of CnsAlns
+	char* qaln;
+	char* saln;
 	
 	bool retrieve_aln_subseqs(int sb, int se, std::string& qstr, std::string& tstr, int& sb_out)
 	{
@@ -55,47 +58,57 @@ struct CnsAln
 			++aln_idx;
 			if (saln[aln_idx] != GAP) ++soff;
 		}
-		qstr += qaln[aln_idx];
-		tstr += saln[aln_idx];
+		const int from = aln_idx;
 		while (soff < se && aln_idx < aln_size - 1)
 		{
 			++aln_idx;
 			if (saln[aln_idx] != GAP) ++soff;
-			qstr += qaln[aln_idx];
-			tstr += saln[aln_idx];
 		}
+		qstr.assign(qaln + from, aln_idx - from + 1);
+		tstr.assign(saln + from, aln_idx - from + 1);
 		return true;
 	}
 };
 
+// The alignments of the read being corrected. The aligned strings are stored
+// back to back at their real length in an arena that is reused for every read.
 class CnsAlns
 {
 public:
 	CnsAlns()
 	{
 		safe_malloc(cns_alns_, CnsAln, MAX_CNS_OVLPS);
+		arena_size_ = kInitArenaSize;
+		safe_malloc(arena_, char, arena_size_);
 		clear();
 	}
 	~CnsAlns()
 	{
 		safe_free(cns_alns_);
+		safe_free(arena_);
 	}
-	void clear() { num_alns_ = 0; }
+	void clear() { num_alns_ = 0; arena_used_ = 0; }
 	int num_alns() { return num_alns_; }
 	CnsAln* begin() { return cns_alns_; }
 	CnsAln* end() { return cns_alns_ + num_alns_; }
 	void add_aln(const int soff, const int send, const std::string& qstr, const std::string& tstr)
 	{
 		r_assert(qstr.size() == tstr.size());
+		r_assert(num_alns_ < MAX_CNS_OVLPS);
+		const size_t n = qstr.size();
+		reserve_arena(arena_used_ + 2 * (n + 1));
 		CnsAln& a = cns_alns_[num_alns_++];
 		a.soff = soff;
 		a.send = send;
 		a.aln_idx = 0;
-		a.aln_size = qstr.size();
-		memcpy(a.qaln, qstr.data(), qstr.size());
-		a.qaln[qstr.size()] = '\0';
-		memcpy(a.saln, tstr.data(), tstr.size());
-		a.saln[tstr.size()] = '\0';
+		a.aln_size = n;
+		a.qaln = arena_ + arena_used_;
+		a.saln = a.qaln + n + 1;
+		memcpy(a.qaln, qstr.data(), n);
+		a.qaln[n] = '\0';
+		memcpy(a.saln, tstr.data(), n);
+		a.saln[n] = '\0';
+		arena_used_ += 2 * (n + 1);
 	}
 	void get_mapping_ranges(std::vector<MappingRange>& ranges)
 	{
@@ -104,23 +117,86 @@ public:
 	}
 	
 private:
+	void reserve_arena(const size_t size)
+	{
+		if (size <= arena_size_) return;
+		size_t new_size = arena_size_;
+		while (new_size < size) new_size *= 2;
+		safe_realloc(arena_, char, new_size);
+		arena_size_ = new_size;
+		size_t offset = 0;
+		for (int i = 0; i < num_alns_; ++i)
+		{
+			cns_alns_[i].qaln = arena_ + offset;
+			cns_alns_[i].saln = cns_alns_[i].qaln + cns_alns_[i].aln_size + 1;
+			offset += 2 * (cns_alns_[i].aln_size + 1);
+		}
+	}
+	
+private:
+	static const size_t kInitArenaSize = 1 << 20;
+	
 	CnsAln* cns_alns_;
 	int     num_alns_;
+	char*   arena_;
+	size_t  arena_size_;
+	size_t  arena_used_;
 };
 
-#define MAX_CNS_RESULTS 10000
+// The candidates of one partition sorted by sid. Consensus threads take one
+// read at a time from next_read, so a thread that hits deep coverage does not
+// hold up the others.
+struct CnsPartition
+{
+	std::string file_name;
+	ExtensionCandidate* ec_list;
+	idx_t num_ec;
+	// the candidates of the i-th read are [read_starts[i], read_starts[i + 1])
+	std::vector<idx_t> read_starts;
+	idx_t next_read;
+	pthread_mutex_t read_lock;
+	// output sequence number of the first read
+	idx_t first_seq;
+	double load_time;
+	// how long the consensus threads waited for the partition to be loaded
+	double stall_time;
+	
+	CnsPartition() : ec_list(NULL), num_ec(0), next_read(0), first_seq(0), load_time(0.0), stall_time(0.0)
+	{
+		pthread_mutex_init(&read_lock, NULL);
+	}
+	~CnsPartition()
+	{
+		delete[] ec_list;
+		pthread_mutex_destroy(&read_lock);
+	}
+	idx_t num_reads() const { return read_starts.size() - 1; }
+	bool get_next_read(idx_t& sid, idx_t& eid, idx_t& seq)
+	{
+		pthread_mutex_lock(&read_lock);
+		const idx_t i = next_read;
+		if (i < num_reads()) ++next_read;
+		pthread_mutex_unlock(&read_lock);
+		if (i >= num_reads()) return false;
+		sid = read_starts[i];
+		eid = read_starts[i + 1];
+		seq = first_seq + i;
+		return true;
+	}
+};
 
 struct ConsensusThreadData
 {
 	ReadsCorrectionOptions rco;
 	int thread_id;
 	PackedDB* reads;
+	CnsPartition* partition;
 	ExtensionCandidate* candidates;
-	int num_candidates;
 	ns_banded_sw::DiffRunningData* drd_s;
 	ns_banded_sw::DiffRunningData* drd_l;
 	M5Record* m5;
 	CnsAlns cns_alns;
+	ns_meap_cns::AlnGraph aln_graph;
 	std::vector<CnsResult> cns_results;
 	std::vector<char> query;
 	std::vector<char> target;
@@ -128,20 +204,22 @@ struct ConsensusThreadData
 	std::string saln;
 	CnsTableItem* cns_table;
 	uint1* id_list;
-	std::ostream* out;
-	pthread_mutex_t out_lock;
+	CnsResultWriter* writer;
+	// time spent on the current partition
+	double busy_time;
 	
-	ConsensusThreadData(ReadsCorrectionOptions* prco, int tid, PackedDB* r, ExtensionCandidate* ec, int nec, std::ostream* output)
+	ConsensusThreadData(ReadsCorrectionOptions* prco, int tid, PackedDB* r, CnsResultWriter* w)
 	{
 		rco = (*prco);
 		thread_id = tid;
 		reads = r;
-		candidates = ec;
-		num_candidates = nec;
+		partition = NULL;
+		candidates = NULL;
 		drd_s = new ns_banded_sw::DiffRunningData(ns_banded_sw::get_sw_parameters_small());
 		drd_l = new ns_banded_sw::DiffRunningData(ns_banded_sw::get_sw_parameters_large());
 		m5 = NewM5Record(MAX_SEQ_SIZE);
-		out = output;
+		writer = w;
+		busy_time = 0.0;
 		
 		query.reserve(MAX_SEQ_SIZE);
 		target.reserve(MAX_SEQ_SIZE);
@@ -149,7 +227,6 @@ struct ConsensusThreadData
 		saln.reserve(MAX_SEQ_SIZE);
 		safe_malloc(cns_table, CnsTableItem, MAX_SEQ_SIZE);
 		safe_malloc(id_list, uint1, MAX_SEQ_SIZE);
-		pthread_mutex_init(&out_lock, NULL);
 	}
 	
 	~ConsensusThreadData()
@@ -164,14 +241,38 @@ struct ConsensusThreadData
 
 void normalize_gaps(const char* qstr, const char* tstr, const index_t aln_size, std::string& qnorm, std::string& tnorm, const bool push);
 
+// Loads a partition in a background thread, so the next partition is read
+// and sorted while the consensus threads work on the current one. Start the
+// next partition after wait() returns the current one and delete the current
+// one when it is done, then at most two partitions are in memory.
+class CnsPartitionLoader
+{
+public:
+	// the overlaps of repeat reads are dropped if repeat_reads is not NULL
+	CnsPartitionLoader(const std::vector<char>* repeat_reads) 
+		: repeat_reads_(repeat_reads), partition_(NULL), running_(false), 
+		  num_loaded_(0), load_time_(0.0), stall_time_(0.0) {}
+	~CnsPartitionLoader() { delete wait(); }
+	void start(const char* file_name);
+	CnsPartition* wait();
+	// reports how much of the loading time was hidden behind consensus
+	void report();
+	
+private:
+	static void* load_func(void* arg);
+	
+private:
+	const std::vector<char>* repeat_reads_;
+	CnsPartition* partition_;
+	pthread_t tid_;
+	bool running_;
+	int num_loaded_;
+	double load_time_;
+	double stall_time_;
+};
+
+// reports how evenly the threads finished
 void
-build_cns_thrd_data_can(ExtensionCandidate* ec_list, 
-						const int nec,
-						const idx_t min_rid,
-						const idx_t max_rid,
-						ReadsCorrectionOptions* prco,
-						PackedDB* reads,
-						std::ostream* out,
-					    ConsensusThreadData** ppctd);
+report_cns_partition(CnsPartition* partition, ConsensusThreadData** pctds, const int num_threads);
 
 #endif // _READS_CORRECTION_AUX_H
@@ -10,89 +10,82 @@ void*
 reads_correction_func_m4(void* arg)
 {
     ConsensusThreadData& cns_data = *static_cast<ConsensusThreadData*>(arg);
-	ExtensionCandidate* overlaps = cns_data.candidates;
-	const index_t num_ovlps = cns_data.num_candidates;
-    index_t i = 0, j;
-    while (i < num_ovlps)
+	CnsPartition& partition = *cns_data.partition;
+	ExtensionCandidate* candidates = cns_data.candidates;
+	Timer timer;
+	timer.go();
+    index_t i, j, seq;
+    while (partition.get_next_read(i, j, seq))
     {
-        const index_t sid = overlaps[i].sid;
-        j = i + 1;
-        while (j < num_ovlps && overlaps[j].sid == sid) ++j;
-        if (j - i < cns_data.rco.min_cov) { i = j; continue; }
-        if (overlaps[i].ssize < cns_data.rco.min_size * 0.95) { i = j; continue; }
+        const index_t sid = candidates[i].sid;
+        if (j - i < cns_data.rco.min_cov || candidates[i].ssize < cns_data.rco.min_size * 0.95)
+        {
+            cns_data.writer->end_read(cns_data.thread_id, seq);
+            continue;
+        }
 		if (cns_data.rco.tech == TECH_PACBIO) {
 			ns_meap_cns::consensus_one_read_m4_pacbio(&cns_data, sid, i, j);
 		} else {
 			ns_meap_cns::consensus_one_read_m4_nanopore(&cns_data, sid, i, j);
 		}
-		if (cns_data.cns_results.size() >= MAX_CNS_RESULTS)
-		{
-			pthread_mutex_lock(&cns_data.out_lock);
-			for (std::vector<CnsResult>::iterator iter = cns_data.cns_results.begin(); iter != cns_data.cns_results.end(); ++iter)
-			{
-				(*cns_data.out) << ">" << iter->id << "_" << iter->range[0] << "_" << iter->range[1] << "_" << iter->seq.size() << "\n";
-				std::string& seq = iter->seq;
-				(*cns_data.out) << seq << "\n";
-			}
-			cns_data.cns_results.clear();
-			pthread_mutex_unlock(&cns_data.out_lock);
-		}
-        i = j;
+		cns_data.writer->add_results(cns_data.thread_id, cns_data.cns_results);
+		cns_data.writer->end_read(cns_data.thread_id, seq);
     }
+	cns_data.writer->flush(cns_data.thread_id);
+	timer.stop();
+	cns_data.busy_time = timer.elapsed();
     return NULL;
 }
 
 void
-consensus_one_partition_m4(const char* m4_file_name,
-        const index_t min_read_id,
-        const index_t max_read_id,
-        ReadsCorrectionOptions& rco,
-        PackedDB& reads,
-        std::ostream& out)
+consensus_one_partition_m4(CnsPartition* partition,
+						ConsensusThreadData** pctds,
+						ReadsCorrectionOptions& rco)
 {
-	idx_t num_ec;
-	ExtensionCandidate* ec_list = load_partition_data<ExtensionCandidate>(m4_file_name, num_ec);
-    ConsensusThreadData* pctds[rco.num_threads];
-	build_cns_thrd_data_can(ec_list, num_ec, min_read_id, max_read_id, &rco, &reads, &out, pctds);
-    pthread_t thread_ids[rco.num_threads];
-    for (int i = 0; i < rco.num_threads; ++i)
-        pthread_create(&thread_ids[i], NULL, reads_correction_func_m4, static_cast<void*>(pctds[i]));
-    for (int i = 0; i < rco.num_threads; ++i)
-        pthread_join(thread_ids[i], NULL);
+	pthread_t thread_ids[rco.num_threads];
 	for (int i = 0; i < rco.num_threads; ++i)
 	{
-		std::vector<CnsResult>& cns_results = pctds[i]->cns_results;
-		for (std::vector<CnsResult>::iterator iter = cns_results.begin(); iter != cns_results.end(); ++iter)
-		{
-			out << ">" << iter->id << "_" << iter->range[0] << "_" << iter->range[1] << "_" << iter->seq.size() << "\n";
-			std::string& seq = iter->seq;
-			out << seq << "\n";
-		}
+		pctds[i]->partition = partition;
+		pctds[i]->candidates = partition->ec_list;
+		pthread_create(&thread_ids[i], NULL, reads_correction_func_m4, static_cast<void*>(pctds[i]));
 	}
-
-    delete[] ec_list;
-    for (int i = 0; i < rco.num_threads; ++i) delete pctds[i];
+	for (int i = 0; i < rco.num_threads; ++i)
+		pthread_join(thread_ids[i], NULL);
+	report_cns_partition(partition, pctds, rco.num_threads);
 }
 
 int reads_correction_m4(ReadsCorrectionOptions& rco)
 {
     double mapping_ratio = rco.min_mapping_ratio - 0.02;
-	partition_m4records(rco.m4, mapping_ratio, rco.batch_size, rco.min_size);
+	std::vector<char> repeat_reads;
+	partition_m4records(rco.m4, mapping_ratio, rco.batch_size, rco.min_size, repeat_reads);
 	std::string idx_file_name;
 	generate_partition_index_file_name(rco.m4, idx_file_name);
 	std::vector<PartitionFileInfo> partition_file_vec;
 	load_partition_files_info(idx_file_name.c_str(), partition_file_vec);
 	PackedDB reads;
-	reads.load_fasta_db(rco.reads);
-	std::ofstream out;
-	open_fstream(out, rco.corrected_reads, std::ios::out);
+	reads.open_fasta_db(rco.reads);
+	CnsResultWriter writer(rco.corrected_reads, rco.num_threads, rco.ordered_output);
+	ConsensusThreadData* pctds[rco.num_threads];
+	for (int i = 0; i < rco.num_threads; ++i) pctds[i] = new ConsensusThreadData(&rco, i, &reads, &writer);
+	CnsPartitionLoader loader(rco.filter_repeat_reads ? &repeat_reads : NULL);
+	if (!partition_file_vec.empty()) loader.start(partition_file_vec[0].file_name.c_str());
 	char process_info[1024];
-	for (std::vector<PartitionFileInfo>::iterator iter = partition_file_vec.begin(); iter != partition_file_vec.end(); ++iter)
+	idx_t num_reads = 0;
+	for (size_t i = 0; i < partition_file_vec.size(); ++i)
 	{
-		sprintf(process_info, "processing %s", iter->file_name.c_str());
+		sprintf(process_info, "processing %s", partition_file_vec[i].file_name.c_str());
 		DynamicTimer dtimer(process_info);
-		consensus_one_partition_m4(iter->file_name.c_str(), iter->min_seq_id, iter->max_seq_id, rco, reads, out);
+		CnsPartition* partition = loader.wait();
+		partition->first_seq = num_reads;
+		num_reads += partition->num_reads();
+		if (i + 1 < partition_file_vec.size()) loader.start(partition_file_vec[i + 1].file_name.c_str());
+		consensus_one_partition_m4(partition, pctds, rco);
+		delete partition;
 	}
+	loader.report();
+	for (int i = 0; i < rco.num_threads; ++i) delete pctds[i];
+	writer.close();
 	
 	return 0;
 }
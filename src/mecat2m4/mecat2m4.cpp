@@ -0,0 +1,115 @@
+#include "../common/record_stream.h"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+void print_usage(const char* prog)
+{
+	cerr << "USAGE:\n"
+		 << prog << " view input [output]\n"
+		 << "\tprint a record stream written by mecat2pw -b 1 as a can or M4 text file\n"
+		 << prog << " pack input output\n"
+		 << "\tconvert a can or M4 text file to a record stream\n";
+}
+
+#define BATCH_SIZE 100000
+
+int
+view(const char* input, ostream& out)
+{
+	OverlapRecordReader reader(input);
+	if (!reader.is_binary()) ERROR("'%s' is not a record stream", input);
+	if (reader.record_type() == RECORD_STREAM_CANDIDATE)
+	{
+		ExtensionCandidate ec;
+		while (reader.next(ec)) print_candidate_text(out, ec);
+	}
+	else
+	{
+		M4Record m4;
+		while (reader.next(m4)) print_m4record_text(out, m4, reader.has_ext());
+	}
+	return 0;
+}
+
+// the record type is told from the number of fields of the first line:
+// 9 for candidates, 12 for M4 records, 14 for M4 records with extension start points
+int
+pack(const char* input, const char* output)
+{
+	ifstream in;
+	open_fstream(in, input, ios::in);
+	string line;
+	int num_fields = 0;
+	if (getline(in, line))
+	{
+		istringstream ins(line);
+		string field;
+		while (ins >> field) ++num_fields;
+	}
+	close_fstream(in);
+	if (num_fields != 0 && num_fields != 9 && num_fields != 12 && num_fields != 14)
+		ERROR("'%s' is neither a can nor an M4 file, its first line has %d fields", input, num_fields);
+
+	OverlapRecordReader reader(input);
+	if (reader.is_binary()) ERROR("'%s' is already a record stream", input);
+	ofstream out;
+	open_fstream(out, output, ios::out | ios::binary);
+	idx_t num_records = 0;
+	if (num_fields == 9)
+	{
+		write_record_stream_header(out, RECORD_STREAM_CANDIDATE, 1);
+		ExtensionCandidate* ec_list = new ExtensionCandidate[BATCH_SIZE];
+		int n = 0;
+		while (reader.next(ec_list[n]))
+			if (++n == BATCH_SIZE)
+			{
+				write_candidate_binary_records(out, ec_list, n);
+				num_records += n;
+				n = 0;
+			}
+		write_candidate_binary_records(out, ec_list, n);
+		num_records += n;
+		delete[] ec_list;
+	}
+	else
+	{
+		const int has_ext = num_fields == 14;
+		write_record_stream_header(out, RECORD_STREAM_M4, has_ext);
+		M4Record* m4_list = new M4Record[BATCH_SIZE];
+		int n = 0;
+		while (reader.next(m4_list[n]))
+			if (++n == BATCH_SIZE)
+			{
+				write_m4_binary_records(out, m4_list, n);
+				num_records += n;
+				n = 0;
+			}
+		write_m4_binary_records(out, m4_list, n);
+		num_records += n;
+		delete[] m4_list;
+	}
+	close_fstream(out);
+	LOG(stderr, "%lld records are written to '%s'", (long long)num_records, output);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc >= 3 && argc <= 4 && strcmp(argv[1], "view") == 0)
+	{
+		if (argc == 3) return view(argv[2], cout);
+		ofstream out;
+		open_fstream(out, argv[3], ios::out);
+		int r = view(argv[2], out);
+		close_fstream(out);
+		return r;
+	}
+	if (argc == 4 && strcmp(argv[1], "pack") == 0) return pack(argv[2], argv[3]);
+	print_usage(argv[0]);
+	return 1;
+}
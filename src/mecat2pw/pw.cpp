@@ -1,10 +1,19 @@
 #include "pw_options.h"
 #include "pw_impl.h"
 #include "../common/split_database.h"
+#include "../common/record_stream.h"
 
+#include <cerrno>
 #include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
+#include <utime.h>
 
 #include <sstream>
 #include <string>
@@ -31,18 +40,360 @@ create_volume_results_name_finished(int vid, const char* wrk_dir, string& name)
 	name += os.str();
 }
 
+// with -b 1 every results file starts with a record stream header
 void
-merge_results(const char* output, const char* wrk_dir, const int num_volumes)
+open_results_file(options_t* options, const char* name, ofstream& out)
 {
+	open_fstream(out, name, ios::out | ios::binary);
+	if (!options->output_binary) return;
+	if (options->task == TASK_SEED) write_record_stream_header(out, RECORD_STREAM_CANDIDATE, 1);
+	else write_record_stream_header(out, RECORD_STREAM_M4, options->output_gapped_start_point);
+}
+
+// results left by a run with a different output format are not reused
+bool
+results_are_finished(options_t* options, const char* name)
+{
+	if (access(name, F_OK)) return false;
+	record_stream_header_t header;
+	bool binary = read_record_stream_header(name, &header);
+	if (binary != (options->output_binary != 0)) return false;
+	if (!binary) return true;
+	if (options->task == TASK_SEED) return header.record_type == RECORD_STREAM_CANDIDATE;
+	return header.record_type == RECORD_STREAM_M4 && header.has_ext == options->output_gapped_start_point;
+}
+
+// the header of the first results file is kept, the others are skipped
+void
+append_results(options_t* options, const char* results, const char* output, const bool first)
+{
+	ostringstream cmd;
+	if (options->output_binary && !first) cmd << "tail -c +" << sizeof(record_stream_header_t) + 1 << " " << results;
+	else cmd << "cat " << results;
+	cmd << (first ? " > " : " >> ") << output;
+	assert(system(cmd.str().c_str()) == 0);
+}
+
+void
+merge_results(options_t* options, const char* output, const char* wrk_dir, const int num_volumes)
+{
+	string vrn;
+	for (int i = 0; i < num_volumes; ++i)
+	{
+		create_volume_results_name_finished(i, wrk_dir, vrn);
+		append_results(options, vrn.c_str(), output, i == 0);
+	}
+}
+
+void
+create_pair_results_name(int rvid, int qvid, const char* wrk_dir, const char* suffix, string& name)
+{
+	name = wrk_dir;
+	if (name[name.size() - 1] != '/') name += '/';
+	ostringstream os;
+	os << "r_" << rvid << "_" << qvid << suffix;
+	name += os.str();
+}
+
+void
+merge_pair_results(options_t* options, const char* output, const char* wrk_dir, const int num_volumes)
+{
+	char host[256];
+	gethostname(host, 256);
+	host[255] = '\0';
+	ostringstream tmp_output;
+	tmp_output << output << "." << host << "." << getpid() << ".tmp";
 	string vrn;
+	bool first = true;
+	for (int i = 0; i < num_volumes; ++i)
+		for (int j = i; j < num_volumes; ++j)
+		{
+			create_pair_results_name(i, j, wrk_dir, "", vrn);
+			append_results(options, vrn.c_str(), tmp_output.str().c_str(), first);
+			first = false;
+		}
+	// several processes may finish at the same time, renaming makes their merges harmless
+	assert(rename(tmp_output.str().c_str(), output) == 0);
+}
+
+// Lock files are leases. The holder writes its host, pid and the time it took
+// the lock into it and refreshes its modification time every
+// kLockRefreshSecs while it works. A lock whose holder has died on this host,
+// or that has not been refreshed for kLockLeaseSecs on any host, is stale and
+// can be reclaimed, so a crashed node holds up the others for a while only.
+static const int kLockRefreshSecs = 60;
+static const int kLockLeaseSecs = 600;
+
+struct lock_info_t
+{
+	char host[256];
+	int pid;
+	long since;
+	// seconds since the last refresh
+	long age;
+};
+
+static bool
+read_lock_info(const char* lock_name, lock_info_t* info)
+{
+	struct stat st;
+	if (stat(lock_name, &st)) return false;
+	FILE* in = fopen(lock_name, "r");
+	if (!in) return false;
+	int r = fscanf(in, "%255s %d %ld", info->host, &info->pid, &info->since);
+	fclose(in);
+	if (r < 2) return false;
+	if (r < 3) info->since = st.st_mtime;
+	info->age = (long)time(NULL) - (long)st.st_mtime;
+	return true;
+}
+
+static bool
+is_stale_lock(const char* lock_name)
+{
+	lock_info_t info;
+	// a lock that is still being written is not stale, unless it stays empty past the lease
+	if (!read_lock_info(lock_name, &info))
+	{
+		struct stat st;
+		return stat(lock_name, &st) == 0 && (long)time(NULL) - (long)st.st_mtime > kLockLeaseSecs;
+	}
+	char host[256];
+	gethostname(host, 256);
+	host[255] = '\0';
+	if (strcmp(host, info.host) == 0 && kill(info.pid, 0) == -1 && errno == ESRCH) return true;
+	return info.age > kLockLeaseSecs;
+}
+
+static void
+log_lock_holder(const char* lock_name)
+{
+	lock_info_t info;
+	if (!read_lock_info(lock_name, &info)) return;
+	LOG(stderr, "'%s' is held by process %d on %s since %ld secs, refreshed %ld secs ago, reclaimed after %d secs without refresh",
+		lock_name, info.pid, info.host, (long)time(NULL) - info.since, info.age, kLockLeaseSecs);
+}
+
+// A lock held by this process, a thread refreshes it until it is released.
+class LockLease
+{
+public:
+	LockLease() : held_(false), stop_(false) 
+	{
+		pthread_mutex_init(&mutex_, NULL);
+		pthread_cond_init(&cond_, NULL);
+	}
+	~LockLease() 
+	{ 
+		release(); 
+		pthread_mutex_destroy(&mutex_);
+		pthread_cond_destroy(&cond_);
+	}
+	// returns false if another process holds the lock
+	bool claim(const char* lock_name);
+	void release();
+	
+private:
+	static void* refresh_func(void* arg);
+	
+private:
+	string name_;
+	bool held_;
+	bool stop_;
+	pthread_t tid_;
+	pthread_mutex_t mutex_;
+	pthread_cond_t cond_;
+};
+
+bool
+LockLease::claim(const char* lock_name)
+{
+	r_assert(!held_);
+	for (int retry = 0; retry < 2; ++retry)
+	{
+		int fd = open(lock_name, O_CREAT | O_EXCL | O_WRONLY, 0644);
+		if (fd != -1)
+		{
+			char host[256], buf[512];
+			gethostname(host, 256);
+			host[255] = '\0';
+			int n = sprintf(buf, "%s %d %ld\n", host, (int)getpid(), (long)time(NULL));
+			r_assert(write(fd, buf, n) == n);
+			close(fd);
+			name_ = lock_name;
+			held_ = true;
+			stop_ = false;
+			pthread_create(&tid_, NULL, refresh_func, static_cast<void*>(this));
+			return true;
+		}
+		if (errno != EEXIST) ERROR("failed to create lock file '%s'", lock_name);
+		if (!is_stale_lock(lock_name)) return false;
+		// only one of the processes reclaiming a stale lock succeeds in renaming it
+		log_lock_holder(lock_name);
+		char host[256];
+		gethostname(host, 256);
+		host[255] = '\0';
+		ostringstream stale_name;
+		stale_name << lock_name << "." << host << "." << getpid() << ".stale";
+		if (rename(lock_name, stale_name.str().c_str())) return false;
+		unlink(stale_name.str().c_str());
+		LOG(stderr, "reclaim stale lock '%s'", lock_name);
+	}
+	return false;
+}
+
+// the lock file is only removed if it is still ours, it may have been
+// reclaimed by another process if this one stalled past the lease
+void
+LockLease::release()
+{
+	if (!held_) return;
+	pthread_mutex_lock(&mutex_);
+	stop_ = true;
+	pthread_cond_signal(&cond_);
+	pthread_mutex_unlock(&mutex_);
+	pthread_join(tid_, NULL);
+	held_ = false;
+	
+	lock_info_t info;
+	char host[256];
+	gethostname(host, 256);
+	host[255] = '\0';
+	if (read_lock_info(name_.c_str(), &info) && strcmp(info.host, host) == 0 && info.pid == (int)getpid()) {
+		unlink(name_.c_str());
+	} else {
+		LOG(stderr, "lock '%s' was reclaimed by another process", name_.c_str());
+	}
+}
+
+void*
+LockLease::refresh_func(void* arg)
+{
+	LockLease* lease = static_cast<LockLease*>(arg);
+	pthread_mutex_lock(&lease->mutex_);
+	while (!lease->stop_)
+	{
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += kLockRefreshSecs;
+		while (!lease->stop_ && pthread_cond_timedwait(&lease->cond_, &lease->mutex_, &deadline) != ETIMEDOUT);
+		if (lease->stop_) break;
+		if (utime(lease->name_.c_str(), NULL)) LOG(stderr, "failed to refresh lock '%s'", lease->name_.c_str());
+	}
+	pthread_mutex_unlock(&lease->mutex_);
+	return NULL;
+}
+
+bool
+all_pairs_finished(options_t* options, const int num_volumes)
+{
+	string name;
 	for (int i = 0; i < num_volumes; ++i)
+		for (int j = i; j < num_volumes; ++j)
+		{
+			create_pair_results_name(i, j, options->wrk_dir, "", name);
+			if (!results_are_finished(options, name.c_str())) return false;
+		}
+	return true;
+}
+
+// volume pairs (i, j), j >= i, are claimed one at a time through lock files in the
+// working folder, so that processes sharing it never align the same pair twice.
+void
+process_volume_pairs(options_t* options, volume_names_t* vn)
+{
+	const int num_vols = vn->num_vols;
+	string finished_name, working_name, lock_name;
+	int num_processed = 0;
+	for (int i = 0; i < num_vols; ++i)
+		for (int j = i; j < num_vols; ++j)
+		{
+			create_pair_results_name(i, j, options->wrk_dir, "", finished_name);
+			if (results_are_finished(options, finished_name.c_str())) continue;
+			create_pair_results_name(i, j, options->wrk_dir, ".lock", lock_name);
+			LockLease lock;
+			if (!lock.claim(lock_name.c_str()))
+			{
+				log_lock_holder(lock_name.c_str());
+				continue;
+			}
+			if (results_are_finished(options, finished_name.c_str())) continue;
+			LOG(stderr, "claim volume pair (%d, %d)", i, j);
+			create_pair_results_name(i, j, options->wrk_dir, ".working", working_name);
+			ofstream out;
+			open_results_file(options, working_name.c_str(), out);
+			string stats_name;
+			create_pair_results_name(i, j, options->wrk_dir, ".stats.json", stats_name);
+			process_one_volume(options, i, j, j + 1, vn, &out, stats_name.c_str());
+			close_fstream(out);
+			assert(rename(working_name.c_str(), finished_name.c_str()) == 0);
+			lock.release();
+			++num_processed;
+		}
+	LOG(stderr, "%d volume pairs are processed by this process", num_processed);
+}
+
+void
+remove_stale_results(const char* wrk_dir)
+{
+	char vol_idx_file_name[1024];
+	generate_idx_file_name(wrk_dir, vol_idx_file_name);
+	if (access(vol_idx_file_name, F_OK)) return;
+	volume_names_t* vn = load_volume_names(vol_idx_file_name, 0);
+	string vrn;
+	for (int i = 0; i < vn->num_vols; ++i)
 	{
 		create_volume_results_name_finished(i, wrk_dir, vrn);
-		ostringstream cmd;
-		if (i == 0) cmd << "cat " << vrn << " >" << output;
-		else cmd << "cat " << vrn << " >> " << output;
-		assert(system(cmd.str().c_str()) == 0);
+		unlink(vrn.c_str());
+		for (int j = i; j < vn->num_vols; ++j)
+		{
+			create_pair_results_name(i, j, wrk_dir, "", vrn);
+			unlink(vrn.c_str());
+		}
 	}
+	vn = delete_volume_names_t(vn);
+}
+
+int
+prepare_volumes(options_t* options)
+{
+	int num_vols = check_split_manifest(options->reads, options->wrk_dir, options->volume_size, options->kmer_size, options->minimizer_window);
+	if (num_vols >= 0)
+	{
+		LOG(stderr, "volumes in '%s' are up to date with '%s', skip splitting.", options->wrk_dir, options->reads);
+		return num_vols;
+	}
+	
+	string split_lock_name = options->wrk_dir;
+	LockLease split_lock;
+	if (options->shared_wrk_dir)
+	{
+		// only one of the processes sharing the working folder splits the reads
+		if (split_lock_name[split_lock_name.size() - 1] != '/') split_lock_name += '/';
+		split_lock_name += "split.lock";
+		for (int waited = 0; !split_lock.claim(split_lock_name.c_str()); waited += 10)
+		{
+			if (waited % kLockRefreshSecs == 0) log_lock_holder(split_lock_name.c_str());
+			sleep(10);
+			num_vols = check_split_manifest(options->reads, options->wrk_dir, options->volume_size, options->kmer_size, options->minimizer_window);
+			if (num_vols >= 0) return num_vols;
+		}
+		num_vols = check_split_manifest(options->reads, options->wrk_dir, options->volume_size, options->kmer_size, options->minimizer_window);
+		if (num_vols >= 0) return num_vols;
+	}
+	
+	char manifest_file_name[1024];
+	generate_manifest_file_name(options->wrk_dir, manifest_file_name);
+	if (access(manifest_file_name, F_OK) == 0)
+	{
+		LOG(stderr, "dataset '%s' or the index options have changed, discard previous results.", options->reads);
+		remove_stale_results(options->wrk_dir);
+		unlink(manifest_file_name);
+	}
+	num_vols = split_raw_dataset(options->reads, options->wrk_dir, options->volume_size, options->kmer_size, options->minimizer_window, options->num_threads);
+	dump_split_manifest(options->reads, options->wrk_dir, options->volume_size, options->kmer_size, options->minimizer_window, num_vols);
+	split_lock.release();
+	return num_vols;
 }
 
 int main(int argc, char* argv[])
@@ -55,18 +406,27 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 	
-	int num_vols = split_raw_dataset(options.reads, options.wrk_dir);
+	int num_vols = prepare_volumes(&options);
 	
 	char vol_idx_file_name[1024];
 	generate_idx_file_name(options.wrk_dir, vol_idx_file_name);
 	cout << vol_idx_file_name << "\n";
 	volume_names_t* vn = load_volume_names(vol_idx_file_name, 0);
 	r_assert(num_vols == vn->num_vols);
+	if (options.shared_wrk_dir)
+	{
+		process_volume_pairs(&options, vn);
+		if (all_pairs_finished(&options, num_vols)) merge_pair_results(&options, options.output, options.wrk_dir, num_vols);
+		else LOG(stderr, "volume pairs are still being processed by other processes, leave merging to them");
+		vn = delete_volume_names_t(vn);
+		return 0;
+	}
+	
 	for (int i = 0; i < vn->num_vols; ++i)
 	{
 		string volume_results_name_finished;
 		create_volume_results_name_finished(i, options.wrk_dir, volume_results_name_finished);
-		if (access(volume_results_name_finished.c_str(), F_OK) == 0) 
+		if (results_are_finished(&options, volume_results_name_finished.c_str()))
 		{
 			LOG(stderr, "volume %d has been finished\n", i);
 			continue;
@@ -74,12 +434,13 @@ int main(int argc, char* argv[])
 		string volume_results_name_working;
 		create_volume_results_name_working(i, options.wrk_dir, volume_results_name_working);
 		ofstream out;
-		open_fstream(out, volume_results_name_working.c_str(), ios::out);
-		process_one_volume(&options, i, vn->num_vols, vn, &out);
+		open_results_file(&options, volume_results_name_working.c_str(), out);
+		string stats_name = volume_results_name_finished + ".stats.json";
+		process_one_volume(&options, i, i, vn->num_vols, vn, &out, stats_name.c_str());
 		close_fstream(out);
 		assert(rename(volume_results_name_working.c_str(), volume_results_name_finished.c_str()) == 0);
 	}
 	vn = delete_volume_names_t(vn);
 	
-	merge_results(options.output, options.wrk_dir, num_vols);
+	merge_results(&options, options.output, options.wrk_dir, num_vols);
 }
@@ -2,8 +2,10 @@
 #include "pw_options.h"
 #include "../common/diff_gapalign.h"
 #include "../common/xdrop_gapalign.h"
+#include "../common/bitvec_gapalign.h"
 #include "../common/packed_db.h"
 #include "../common/lookup_table.h"
+#include "../common/record_stream.h"
 #include "pw_impl.h"
 
 #include <algorithm>
@@ -15,9 +17,14 @@
 
 #define MSS MAX_SEQ_SIZE
 
-static int MAXC = 100;
 static int output_gapped_start_point = 1;
-static int kmer_size = 13;
+static int output_binary = 0;
+static int kmer_size = KMER_SIZE;
+// 0 = the query k-mers are sampled every BC bases and matched against every
+// k-mer of the reference, otherwise minimizers are matched against minimizers
+static int minimizer_window = 0;
+// bases between consecutive seed numbers, seed i starts at (i - 1) * seed_step
+static int seed_step = BC;
 static const double ddfs_cutoff_pacbio = 0.25;
 static const double ddfs_cutoff_nanopore = 0.25;
 static double ddfs_cutoff = ddfs_cutoff_pacbio;
@@ -27,8 +34,104 @@ static int min_kmer_dist = 0;
 
 using namespace std;
 
-PWThreadData::PWThreadData(options_t* opt, volume_t* ref, volume_t* rd, ref_index* idx, std::ostream* o)
-	: options(opt), used_thread_id(0), reference(ref), reads(rd), ridx(idx), out(o), m4_results(NULL), ec_results(NULL), next_processed_id(0)
+static inline double
+pw_clock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void
+PWStats::add(const PWStats& s)
+{
+	reads += s.reads;
+	kmers += s.kmers;
+	seeds += s.seeds;
+	segments += s.segments;
+	segments_scored += s.segments_scored;
+	candidates += s.candidates;
+	alignments += s.alignments;
+	accepted += s.accepted;
+	records += s.records;
+	bytes_written += s.bytes_written;
+	seeding_time += s.seeding_time;
+	candidate_time += s.candidate_time;
+	align_time += s.align_time;
+	containment_time += s.containment_time;
+	output_time += s.output_time;
+	lock_wait_time += s.lock_wait_time;
+}
+
+void*
+PWVolumeLoader::load_func(void* arg)
+{
+	PWVolumeLoader* loader = static_cast<PWVolumeLoader*>(arg);
+	Timer timer;
+	timer.go();
+	loader->volume_ = load_volume(loader->vol_name_);
+	timer.stop();
+	loader->last_load_time_ = timer.elapsed();
+	return NULL;
+}
+
+void
+PWVolumeLoader::start(const char* vol_name)
+{
+	r_assert(!running_ && !volume_);
+	vol_name_ = vol_name;
+	pthread_create(&tid_, NULL, load_func, static_cast<void*>(this));
+	running_ = true;
+}
+
+volume_t*
+PWVolumeLoader::wait()
+{
+	if (!running_) return NULL;
+	Timer timer;
+	timer.go();
+	pthread_join(tid_, NULL);
+	timer.stop();
+	running_ = false;
+	volume_t* v = volume_;
+	volume_ = NULL;
+	++num_loaded_;
+	load_time_ += last_load_time_;
+	stall_time_ += timer.elapsed();
+	return v;
+}
+
+void
+PWVolumeLoader::report()
+{
+	LOG(stderr, "%d volumes loaded in %.2f secs, %.2f secs of which were hidden behind alignment", 
+		num_loaded_, load_time_, std::max(load_time_ - stall_time_, 0.0));
+}
+
+// takes the prefetched volume curr_vid and starts loading the one after it
+static void
+open_next_volume(PWThreadData* data)
+{
+	const int vid = data->curr_vid;
+	data->volumes[vid - data->svid] = data->loader.wait();
+	data->volume_timers[vid - data->svid].go();
+	fprintf(stderr, "[process volume %d] begins.\n", vid);
+	LOG(stderr, "processing %s\n", get_vol_name(data->vn, vid));
+	if (vid + 1 < data->evid) data->loader.start(get_vol_name(data->vn, vid + 1));
+}
+
+static void
+close_volume(PWThreadData* data, const int vid)
+{
+	const int k = vid - data->svid;
+	data->volume_timers[k].stop();
+	fprintf(stderr, "[process volume %d] takes %.2f secs.\n", vid, data->volume_timers[k].elapsed());
+	data->volumes[k] = delete_volume_t(data->volumes[k]);
+}
+
+PWThreadData::PWThreadData(options_t* opt, volume_t* ref, ref_index* idx, std::ostream* o, volume_names_t* names, const int sv, const int ev)
+	: options(opt), used_thread_id(0), reference(ref), ridx(idx), out(o), m4_results(NULL), ec_results(NULL), 
+	  vn(names), svid(sv), evid(ev), curr_vid(sv), next_processed_id(0)
 {
 	pthread_mutex_init(&id_lock, NULL);
 	if (options->task == TASK_SEED)
@@ -50,6 +153,17 @@ PWThreadData::PWThreadData(options_t* opt, volume_t* ref, volume_t* rd, ref_inde
 	}
 	pthread_mutex_init(&result_write_lock, NULL);
 	pthread_mutex_init(&read_retrieve_lock, NULL);
+	stats = new PWStats[options->num_threads];
+	
+	const int num_vols = std::max(evid - svid, 1);
+	safe_calloc(volumes, volume_t*, num_vols);
+	safe_calloc(active_chunks, int, num_vols);
+	volume_timers = new Timer[num_vols];
+	if (svid < evid)
+	{
+		loader.start(get_vol_name(vn, svid));
+		open_next_volume(this);
+	}
 }
 
 PWThreadData::~PWThreadData()
@@ -64,20 +178,18 @@ PWThreadData::~PWThreadData()
 		for (int i = 0; i < options->num_threads; ++i) safe_free(m4_results[i]);
 		safe_free(m4_results);
 	}
+	for (int i = 0; i < evid - svid; ++i) if (volumes[i]) delete_volume_t(volumes[i]);
+	safe_free(volumes);
+	safe_free(active_chunks);
+	delete[] volume_timers;
+	delete[] stats;
+	loader.report();
 }
 
 void
 reverse_complement(char* dst, const char* src, const int size)
 {
-	const uint8_t* rc_table = get_dna_complement_table();
-	int i;
-	for (i = 0; i < size; ++i)
-	{
-		uint8_t c = src[i];
-		assert(c >= 0 && c < 4);
-		c = rc_table[c];
-		dst[size - 1 - i] = c;
-	}
+	reverse_complement_codes(dst, src, size);
 }
 
 int
@@ -96,18 +208,17 @@ extract_kmers(const char* s, const int ssize, int* kmer_ids)
 	return num_kmers;
 }
 
-SeedingBK::SeedingBK(const int ref_size)
+SeedingBK::SeedingBK() : num_buckets(0), max_buckets(1024), table(NULL), table_bits(0), table_pos(NULL)
 {
-	const int num_segs = ref_size / ZV + 5;
-	safe_malloc(index_list, int, num_segs);
-	safe_malloc(index_score, short, num_segs);
-	safe_malloc(database, Back_List, num_segs);
+	safe_malloc(index_list, int, max_buckets);
+	safe_malloc(index_score, short, max_buckets);
+	safe_malloc(database, Back_List, max_buckets);
+	safe_malloc(table_pos, int, max_buckets);
 	safe_malloc(kmer_ids, int, MAX_SEQ_SIZE);
-	for (int i = 0; i < num_segs; ++i) 
-	{
-		database[i].score = 0;
-		database[i].index = -1;
-	}
+	safe_malloc(kmer_pos, int, MAX_SEQ_SIZE);
+	empty.score = 0;
+	empty.index = -1;
+	rehash(11);
 }
 
 SeedingBK::~SeedingBK()
@@ -115,7 +226,69 @@ SeedingBK::~SeedingBK()
 	safe_free(index_list);
 	safe_free(index_score);
 	safe_free(database);
+	safe_free(table);
+	safe_free(table_pos);
 	safe_free(kmer_ids);
+	safe_free(kmer_pos);
+}
+
+void
+SeedingBK::rehash(const int bits)
+{
+	safe_free(table);
+	table_bits = bits;
+	const unsigned mask = (1U << table_bits) - 1;
+	safe_malloc(table, int, mask + 1);
+	memset(table, -1, sizeof(int) * (mask + 1));
+	for (int b = 0; b < num_buckets; ++b)
+	{
+		unsigned p = slot_of(index_list[b]);
+		while (table[p] != -1) p = (p + 1) & mask;
+		table[p] = b;
+		table_pos[b] = p;
+	}
+}
+
+Back_List*
+SeedingBK::get(const int seg_id)
+{
+	const unsigned mask = (1U << table_bits) - 1;
+	unsigned p = slot_of(seg_id);
+	for (; table[p] != -1; p = (p + 1) & mask)
+		if (index_list[table[p]] == seg_id) return database + table[p];
+	
+	if (num_buckets == max_buckets)
+	{
+		max_buckets *= 2;
+		safe_realloc(index_list, int, max_buckets);
+		safe_realloc(index_score, short, max_buckets);
+		safe_realloc(database, Back_List, max_buckets);
+		safe_realloc(table_pos, int, max_buckets);
+	}
+	const int b = num_buckets++;
+	index_list[b] = seg_id;
+	index_score[b] = 0;
+	database[b].score = 0;
+	database[b].index = b;
+	// keep the table at most half full
+	if (2 * num_buckets > (1 << table_bits)) 
+	{
+		rehash(table_bits + 1);
+	}
+	else
+	{
+		table[p] = b;
+		table_pos[b] = p;
+	}
+	return database + b;
+}
+
+void
+SeedingBK::clear()
+{
+	for (int b = 0; b < num_buckets; ++b) table[table_pos[b]] = -1;
+	num_buckets = 0;
+	empty.score = 0;
 }
 
 void insert_loc(Back_List *spr,int loc,int seedn,float len)
@@ -238,89 +411,135 @@ int find_location(int *t_loc,int *t_seedn,int *t_score,int *loc,int k,int *rep_l
     else return(0);
 }
 
+// adds the seeds of one k-mer, T is int or idx_t depending on the width of the index
+template <typename T>
+static void
+add_seeds(const T* seed_arr, const int num_seeds, const int seedn, SeedingBK* sbk)
+{
+	int sid;
+	int endnum = 0;
+	for (sid = 0; sid < num_seeds; ++sid)
+	{
+		int seg_id = seed_arr[sid] / ZV;
+		int seg_off = seed_arr[sid] % ZV;
+		Back_List* spr = sbk->get(seg_id);
+		if (spr->score == 0 || spr->seednum < seedn)
+		{
+			int loc = ++spr->score;
+			if (loc <= SM) { spr->loczhi[loc - 1] = seg_off; spr->seedno[loc - 1] = seedn; }
+			else insert_loc(spr, seg_off, seedn, seed_step);
+			int s_k;
+			if (seg_id > 0) s_k = spr->score + sbk->find(seg_id - 1)->score;
+			else s_k = spr->score;
+			if (endnum < s_k) endnum = s_k;
+			sbk->index_score[spr->index] = s_k;
+		}
+		spr->seednum = seedn;
+	}
+}
+
 int
-seeding(const char* read, const int read_size, ref_index* ridx, SeedingBK* sbk)
+seeding(const char* read, const int read_size, ref_index* ridx, SeedingBK* sbk, PWStats* stats)
 {
 	int* kmer_ids = sbk->kmer_ids;
-	int* index_list = sbk->index_list;
-	int* index_spr = index_list;
-	short* index_score = sbk->index_score;
-	short* index_ss = index_score;
-	Back_List* database = sbk->database;
+	int* kmer_pos = sbk->kmer_pos;
 	
-	int num_kmers = extract_kmers(read, read_size, kmer_ids);
+	int num_kmers;
+	if (minimizer_window) num_kmers = extract_minimizers(read, read_size, kmer_size, minimizer_window, kmer_ids, kmer_pos);
+	else num_kmers = extract_kmers(read, read_size, kmer_ids);
 	int km;
-	int used_segs = 0;
 	for (km = 0; km < num_kmers; ++km)
 	{
+		const int seedn = minimizer_window ? kmer_pos[km] + 1 : km + 1;
 		int num_seeds = ridx->kmer_counts[kmer_ids[km]];
-		int* seed_arr = ridx->kmer_starts[kmer_ids[km]];
-		int sid;
-		int endnum = 0;
-		for (sid = 0; sid < num_seeds; ++sid)
-		{
-			int seg_id = seed_arr[sid] / ZV;
-			int seg_off = seed_arr[sid] % ZV;
-			Back_List* spr = database + seg_id;
-			if (spr->score == 0 || spr->seednum < km + 1)
-			{
-				int loc = ++spr->score;
-				if (loc <= SM) { spr->loczhi[loc - 1] = seg_off; spr->seedno[loc - 1] = km + 1; }
-				else insert_loc(spr, seg_off, km + 1, BC);
-				int s_k;
-				if (seg_id > 0) s_k = spr->score + (spr - 1)->score;
-				else s_k = spr->score;
-				if (endnum < s_k) endnum = s_k;
-				if (spr->index == -1)
-				{
-					*(index_spr++) = seg_id;
-					*(index_ss++) = s_k;
-					spr->index = used_segs++;
-				}
-				else index_score[spr->index] = s_k;
-			}
-			spr->seednum = km + 1;
-		}
+		void* seed_arr = ridx->kmer_starts[kmer_ids[km]];
+		stats->seeds += num_seeds;
+		if (ridx->wide) add_seeds((const idx_t*)seed_arr, num_seeds, seedn, sbk);
+		else add_seeds((const int*)seed_arr, num_seeds, seedn, sbk);
+	}
+	stats->kmers += num_kmers;
+	stats->segments += sbk->num_buckets;
+	return sbk->num_buckets;
+}
+
+// a is better than b
+static inline bool
+candidate_better(const candidate_save& a, const candidate_save& b)
+{
+	return a.score > b.score || (a.score == b.score && a.seq < b.seq);
+}
+
+CandidateHeap::CandidateHeap(const int max_candidates)
+	: size(0), max_size(max_candidates), num_pushed(0)
+{
+	safe_malloc(list, candidate_save, max_size);
+}
+
+CandidateHeap::~CandidateHeap()
+{
+	safe_free(list);
+}
+
+void
+CandidateHeap::push(candidate_save& c)
+{
+	c.seq = num_pushed++;
+	// most reads have fewer candidates than max_size, the heap is only built once the list is full
+	if (size < max_size)
+	{
+		list[size++] = c;
+		if (size == max_size) std::make_heap(list, list + size, candidate_better);
+	}
+	else if (candidate_better(c, list[0]))
+	{
+		std::pop_heap(list, list + size, candidate_better);
+		list[size - 1] = c;
+		std::push_heap(list, list + size, candidate_better);
 	}
-	return used_segs;
 }
 
 int
+CandidateHeap::sort()
+{
+	if (size < max_size) std::sort(list, list + size, candidate_better);
+	else std::sort_heap(list, list + size, candidate_better);
+	return size;
+}
+
+void
 get_candidates(volume_t* ref, 
 			   SeedingBK* sbk, 
 			   const int num_segs, 
 			   const int read_id, 
 			   const int read_size, 
 			   const char chain,
-			   candidate_save* candidates, 
-			   int candidatenum)
+			   CandidateHeap* candidates,
+			   PWStats* stats)
 {
 	int* index_list = sbk->index_list;
 	int* index_spr = index_list;
 	short* index_score = sbk->index_score;
 	short* index_ss = index_score;
-	Back_List* database = sbk->database;
 	const int temp_arr_size = 2 * SM + 10;
 	int temp_list[temp_arr_size],temp_seedn[temp_arr_size],temp_score[temp_arr_size];
-	candidate_save *candidate_loc = candidates, candidate_temp;
+	candidate_save candidate_temp;
 	int location_loc[4],repeat_loc;
 	int i, j, k, u_k;
+	idx_t start_loc;
 	for (i = 0; i < num_segs; ++i, ++index_spr, ++index_ss) 
 		if (*index_ss >= 2 * min_kmer_match)
 		{
-			Back_List *spr = database + (*index_spr), *spr1;
+			Back_List *spr = sbk->database + i, *spr1;
 			if (spr->score == 0) continue;
 			int s_k = spr->score;
-			int start_loc = *index_spr;
-			start_loc = MUL_ZV(start_loc);
+			start_loc = MUL_ZV(*index_spr);
 			int loc;
 			if ((*index_spr) > 0)
 			{
-				loc = (spr - 1)->score;
+				loc = sbk->find(*index_spr - 1)->score;
 				if (loc > 0) 
 				{
-					start_loc = (*index_spr - 1);
-					start_loc = MUL_ZV(start_loc);
+					start_loc = MUL_ZV(*index_spr - 1);
 				}
 			}
 			else loc = 0;
@@ -336,7 +555,7 @@ get_candidates(volume_t* ref,
 			{
 				k = loc;
 				u_k = 0;
-				spr1 = spr - 1;
+				spr1 = sbk->find(*index_spr - 1);
 				for (j = 0; j < k && j < SM; ++j)
 				{
 					temp_list[u_k] = spr1->loczhi[j];
@@ -352,7 +571,8 @@ get_candidates(volume_t* ref,
 			}
 			
 			{
-				int f = find_location(temp_list, temp_seedn, temp_score, location_loc, u_k, &repeat_loc, BC, read_size);
+				int f = find_location(temp_list, temp_seedn, temp_score, location_loc, u_k, &repeat_loc, seed_step, read_size);
+				++stats->segments_scored;
 				if (!f) continue;
 				if (temp_score[repeat_loc] < 2 * min_kmer_match + 2) continue;
 			}
@@ -360,23 +580,23 @@ get_candidates(volume_t* ref,
 			candidate_temp.score = temp_score[repeat_loc];
 			candidate_temp.chain = chain;
 			int loc_seed = temp_seedn[repeat_loc];
-			location_loc[0] = start_loc + location_loc[0];
-			int loc_list = location_loc[0];
-			int sid = get_read_id_from_offset_list(ref->offset_list, location_loc[0]);
-			int sstart = ref->offset_list->offset_list[sid].offset;
+			idx_t loc_list = start_loc + location_loc[0];
+			int sid = get_read_id_from_offset_list(ref->offset_list, loc_list);
+			idx_t sstart = ref->offset_list->offset_list[sid].offset;
 			int ssize = ref->offset_list->offset_list[sid].size;
-			int send = sstart + ssize + 1;
+			idx_t send = sstart + ssize + 1;
 			sid += ref->start_read_id;
 			if (sid > read_id) continue;
 			if (sid == read_id)
 			{
 				u_k = DIV_ZV(sstart);
-				spr = database + u_k;
+				spr = sbk->find(u_k);
 				s_k = MOD_ZV(sstart);
 				for (j = 0, k = 0; j < spr->score && j < SM; ++j)
 					if (spr->loczhi[j] < s_k) { spr->loczhi[k] = spr->loczhi[j]; ++k; }
 				spr->score = k;
-				for (++spr, ++u_k, k = DIV_ZV(send); u_k < k; ++u_k, ++spr) spr->score = 0;
+				for (++u_k, k = DIV_ZV(send); u_k < k; ++u_k) sbk->find(u_k)->score = 0;
+				spr = sbk->find(u_k);
 				for (j = 0, k = 0, s_k = MOD_ZV(send); j < spr->score && j < SM; ++j)
 					if (spr->loczhi[j] > s_k) { spr->loczhi[k] = spr->loczhi[j]; ++k; }
 				spr->score = k;
@@ -385,15 +605,15 @@ get_candidates(volume_t* ref,
 			{
 				candidate_temp.readno = sid;
 				candidate_temp.readstart = sstart;
-				location_loc[1] = (location_loc[1] - 1) * BC;
-				int left_length1 = location_loc[0] - sstart + kmer_size - 1;
-				int right_length1 = send - location_loc[0];
+				location_loc[1] = (location_loc[1] - 1) * seed_step;
+				int left_length1 = loc_list - sstart + kmer_size - 1;
+				int right_length1 = send - loc_list;
 				int left_length2 = location_loc[1] + kmer_size - 1;
 				int right_length2 = read_size - location_loc[1];
 				int num1 = (left_length1 > left_length2) ? left_length2 : left_length1;
 				int num2 = (right_length1 > right_length2) ? right_length2 : right_length1;
 				if (num1 + num2 < min_kmer_dist) continue;
-				candidate_temp.loc1=location_loc[0] - sstart;
+				candidate_temp.loc1=loc_list - sstart;
 				candidate_temp.num1=num1;
 				candidate_temp.loc2=location_loc[1];
 				candidate_temp.num2=num2;
@@ -405,11 +625,11 @@ get_candidates(volume_t* ref,
 				int seedcount = 0;
 				int nlb = (num1 + ZV - 1);
 				nlb = DIV_ZV(nlb);
-				for(u_k=*index_spr-1, spr1=spr-1; u_k>=0&&nlb>0; spr1--,--nlb,u_k--)if(spr1->score>0)
+				for(u_k=*index_spr-1; u_k>=0&&nlb>0; --nlb,u_k--)if((spr1=sbk->find(u_k))->score>0)
 					{
 						start_loc = MUL_ZV(u_k);
 						int scnt = min((int)spr1->score, SM);
-						for(j=0,s_k=0; j < scnt; j++)if(fabs((loc_list-start_loc-spr1->loczhi[j])/((loc_seed-spr1->seedno[j])*BC*1.0)-1.0)<ddfs_cutoff)
+						for(j=0,s_k=0; j < scnt; j++)if(fabs((loc_list-start_loc-spr1->loczhi[j])/((loc_seed-spr1->seedno[j])*seed_step*1.0)-1.0)<ddfs_cutoff)
 							{
 								seedcount++;
 								s_k++;
@@ -422,11 +642,11 @@ get_candidates(volume_t* ref,
 				//find all right seed
 				int nrb = (num2 + ZV - 1);
 				nrb = DIV_ZV(nrb);
-				for(u_k=*index_spr+1,spr1=spr+1; nrb; spr1++,--nrb,u_k++)if(spr1->score>0)
+				for(u_k=*index_spr+1; nrb; --nrb,u_k++)if((spr1=sbk->find(u_k))->score>0)
 					{
 						start_loc = MUL_ZV(u_k);
 						int scnt = min((int)spr1->score, SM);
-						for(j=0,s_k=0; j < scnt; j++)if(fabs((start_loc+spr1->loczhi[j]-loc_list)/((spr1->seedno[j]-loc_seed)*BC*1.0)-1.0)<ddfs_cutoff)
+						for(j=0,s_k=0; j < scnt; j++)if(fabs((start_loc+spr1->loczhi[j]-loc_list)/((spr1->seedno[j]-loc_seed)*seed_step*1.0)-1.0)<ddfs_cutoff)
 							{
 								seedcount++;
 								s_k++;
@@ -438,30 +658,11 @@ get_candidates(volume_t* ref,
 					}
 				
 				candidate_temp.score=candidate_temp.score+seedcount;
-				//insert canidate position or delete this position
-				int low=0;
-				int high=candidatenum-1;
-				int mid;
-				while(low<=high)
-				{
-					mid=(low+high)/2;
-					if(mid>=candidatenum||candidate_loc[mid].score<candidate_temp.score)high=mid-1;
-					else low=mid+1;
-				}
-				if(candidatenum<MAXC)for(u_k=candidatenum-1; u_k>high; u_k--)candidate_loc[u_k+1]=candidate_loc[u_k];
-				else for(u_k=candidatenum-2; u_k>high; u_k--)candidate_loc[u_k+1]=candidate_loc[u_k];
-				if(high+1<MAXC)candidate_loc[high+1]=candidate_temp;
-				if(candidatenum<MAXC)candidatenum++;
-				else candidatenum=MAXC;
+				candidates->push(candidate_temp);
 			}
 		}
 	
-	for(i=0,index_spr=index_list; i<num_segs; i++,index_spr++)
-	{
-		database[*index_spr].score=0;
-		database[*index_spr].index=-1;
-	}
-	return candidatenum;
+	sbk->clear();
 }
 
 void
@@ -533,9 +734,32 @@ void output_m4record(ostream& out, const M4Record& m4)
 void
 print_m4record_list(ostream* out, M4Record* m4_list, int num_m4)
 {
+	if (output_binary)
+	{
+		write_m4_binary_records(*out, m4_list, num_m4);
+		return;
+	}
 	for (int i = 0; i < num_m4; ++i) output_m4record(*out, m4_list[i]);
 }
 
+// writes a list of results under the output lock and empties it
+template <typename T>
+static void
+write_results(PWThreadData* data, PWStats* stats, T* list, int& size, void (*print_list)(ostream*, T*, int))
+{
+	double t = pw_clock();
+	pthread_mutex_lock(&data->result_write_lock);
+	double t1 = pw_clock();
+	stats->lock_wait_time += t1 - t;
+	const idx_t start = data->out->tellp();
+	print_list(data->out, list, size);
+	stats->bytes_written += (idx_t)data->out->tellp() - start;
+	pthread_mutex_unlock(&data->result_write_lock);
+	stats->output_time += pw_clock() - t1;
+	stats->records += size;
+	size = 0;
+}
+
 struct CmpM4RecordByQidAndOvlpSize
 {
 	bool operator()(const M4Record& a, const M4Record& b)
@@ -576,8 +800,9 @@ check_records_containment(M4Record* m4v, int s, int e, int* valid)
 void
 append_m4v(M4Record* glist, int* glist_size,
 		   M4Record* llist, int* llist_size,
-		   ostream* out, pthread_mutex_t* results_write_lock)
+		   PWThreadData* data, PWStats* stats)
 {
+	double t = pw_clock();
 	sort(llist, llist + *llist_size, CmpM4RecordByQidAndOvlpSize());
 	int i = 0, j;
 	int valid[*llist_size];
@@ -591,13 +816,10 @@ append_m4v(M4Record* glist, int* glist_size,
 		i = j;
 	}
 	
+	stats->containment_time += pw_clock() - t;
+	
 	if ((*glist_size) + (*llist_size) > PWThreadData::kResultListSize)
-	{
-		pthread_mutex_lock(results_write_lock);
-		print_m4record_list(out, glist, *glist_size);
-		*glist_size = 0;
-		pthread_mutex_unlock(results_write_lock);
-	}
+		write_results(data, stats, glist, *glist_size, print_m4record_list);
 	
 	for (i = 0; i < *llist_size; ++i)
 		if (valid[i])
@@ -609,14 +831,43 @@ append_m4v(M4Record* glist, int* glist_size,
 	*llist_size = 0;
 }
 
-inline void
-get_next_chunk_reads(PWThreadData* data, int& Lid, int& Rid)
+// Hands out the next chunk of reads, moving on to the next query volume once
+// every chunk of the current one is taken. Returns false if all volumes are taken.
+static bool
+get_next_chunk_reads(PWThreadData* data, volume_t*& reads, int& vid, int& Lid, int& Rid)
+{
+	bool found = false;
+	pthread_mutex_lock(&data->read_retrieve_lock);
+	while (data->curr_vid < data->evid)
+	{
+		const int k = data->curr_vid - data->svid;
+		if (data->next_processed_id < data->volumes[k]->num_reads)
+		{
+			reads = data->volumes[k];
+			vid = data->curr_vid;
+			Lid = data->next_processed_id;
+			Rid = std::min(Lid + CHUNK_SIZE, reads->num_reads);
+			data->next_processed_id += CHUNK_SIZE;
+			++data->active_chunks[k];
+			found = true;
+			break;
+		}
+		if (data->active_chunks[k] == 0) close_volume(data, data->curr_vid);
+		++data->curr_vid;
+		data->next_processed_id = 0;
+		if (data->curr_vid < data->evid) open_next_volume(data);
+	}
+	pthread_mutex_unlock(&data->read_retrieve_lock);
+	return found;
+}
+
+static void
+end_chunk_reads(PWThreadData* data, const int vid)
 {
 	pthread_mutex_lock(&data->read_retrieve_lock);
-	Lid = data->next_processed_id;
-	Rid = Lid + CHUNK_SIZE;
-	if (Rid > data->reads->num_reads) Rid = data->reads->num_reads;
-	data->next_processed_id += CHUNK_SIZE;
+	const int k = vid - data->svid;
+	--data->active_chunks[k];
+	if (data->active_chunks[k] == 0 && vid < data->curr_vid) close_volume(data, vid);
 	pthread_mutex_unlock(&data->read_retrieve_lock);
 }
 
@@ -627,15 +878,20 @@ pairwise_mapping(PWThreadData* data, int tid)
 	safe_malloc(read1, char, MSS);
 	safe_malloc(read2, char, MSS);
 	safe_malloc(subject, char, MSS);
-	SeedingBK* sbk = new SeedingBK(data->reference->curr);
-	candidate_save candidates[MAXC];
+	SeedingBK* sbk = new SeedingBK();
+	const int max_candidates = data->options->num_candidates;
+	CandidateHeap candidate_heap(max_candidates);
+	candidate_save* candidates = candidate_heap.list;
 	int num_candidates = 0;
 	M4Record* m4_list = data->m4_results[tid];
 	int m4_list_size = 0;
-	M4Record* m4v = new M4Record[MAXC];
+	M4Record* m4v = new M4Record[max_candidates];
 	int num_m4 = 0;
+	PWStats* stats = data->stats + tid;
 	GapAligner* aligner = NULL;
-	if (data->options->tech == TECH_PACBIO) {
+	if (data->options->aligner == ALIGNER_BITVEC) {
+		aligner = new BitVectorAligner(0);
+	} else if (data->options->tech == TECH_PACBIO) {
 		aligner = new DiffAligner(0);
 	} else if (data->options->tech == TECH_NANOPORE) {
 		aligner = new XdropAligner(0);
@@ -643,33 +899,39 @@ pairwise_mapping(PWThreadData* data, int tid)
 		ERROR("TECH must be either %d or %d", TECH_PACBIO, TECH_NANOPORE);
 	}
 
-	int rid, Lid, Rid;
-	while (1)
+	volume_t* reads;
+	int rid, vid, Lid, Rid;
+	while (get_next_chunk_reads(data, reads, vid, Lid, Rid))
 	{
-		get_next_chunk_reads(data, Lid, Rid);
-		if (Lid >= data->reads->num_reads) break;
 		for (rid = Lid; rid < Rid; ++rid)
 		{
-			int rsize = data->reads->offset_list->offset_list[rid].size;
-			extract_one_seq(data->reads, rid, read1);
+			int rsize = reads->offset_list->offset_list[rid].size;
+			extract_one_seq(reads, rid, read1);
 			reverse_complement(read2, read1, rsize);
+			++stats->reads;
 			int s;
 			char chain;
-			num_candidates = 0;
+			candidate_heap.clear();
 			for (s = 0; s < 2; ++s)
 			{
 				if (s%2) { chain = 'R'; read = read2; }
 				else { chain = 'F'; read = read1; }
-				int num_segs = seeding(read, rsize, data->ridx, sbk);
-				num_candidates = get_candidates(data->reference, 
+				double t = pw_clock();
+				int num_segs = seeding(read, rsize, data->ridx, sbk, stats);
+				double t1 = pw_clock();
+				stats->seeding_time += t1 - t;
+				get_candidates(data->reference, 
 												sbk, 
 												num_segs, 
-												rid + data->reads->start_read_id, 
+												rid + reads->start_read_id, 
 												rsize, 
 												chain, 
-												candidates, 
-												num_candidates); 
+												&candidate_heap,
+												stats); 
+				stats->candidate_time += pw_clock() - t1;
 			}
+			num_candidates = candidate_heap.sort();
+			stats->candidates += num_candidates;
 
 			for (s = 0; s < num_candidates; ++s)
 			{
@@ -685,11 +947,15 @@ pairwise_mapping(PWThreadData* data, int tid)
 				}
 				int ssize = data->reference->offset_list->offset_list[candidates[s].readno - data->reference->start_read_id].size;
 				
+				double t = pw_clock();
 				int flag = aligner->go(read, qstart, rsize, subject, sstart, ssize, min_align_size);
+				stats->align_time += pw_clock() - t;
+				++stats->alignments;
 				
 				if (flag)
 				{
-					fill_m4record(aligner, rid + data->reads->start_read_id, 
+					++stats->accepted;
+					fill_m4record(aligner, rid + reads->start_read_id, 
 								  candidates[s].readno, candidates[s].chain, 
 								  rsize, ssize, qstart, sstart, candidates[s].score,
 								  m4v + num_m4);
@@ -697,24 +963,28 @@ pairwise_mapping(PWThreadData* data, int tid)
 				}
 			}
 			
-			append_m4v(m4_list, &m4_list_size, m4v, &num_m4, data->out, &data->result_write_lock);
+			append_m4v(m4_list, &m4_list_size, m4v, &num_m4, data, stats);
 		}
+		end_chunk_reads(data, vid);
 	}
-		
-		if (m4_list_size)
-		{
-			pthread_mutex_lock(&data->result_write_lock);
-			print_m4record_list(data->out, m4_list, m4_list_size);
-			m4_list_size = 0;
-			pthread_mutex_unlock(&data->result_write_lock);
-		}
-		
-		safe_free(read1);
-		safe_free(read2);
-		safe_free(subject);
-		delete sbk;
-		delete aligner;
-		delete[] m4v;
+	
+	if (m4_list_size) write_results(data, stats, m4_list, m4_list_size, print_m4record_list);
+	
+	safe_free(read1);
+	safe_free(read2);
+	safe_free(subject);
+	delete sbk;
+	delete aligner;
+	delete[] m4v;
+}
+
+void
+print_candidate_list(ostream* out, ExtensionCandidate* ec_list, int num_ec)
+{
+	if (output_binary)
+		write_candidate_binary_records(*out, ec_list, num_ec);
+	else
+		for (int i = 0; i < num_ec; ++i) print_candidate_text(*out, ec_list[i]);
 }
 
 void
@@ -724,92 +994,89 @@ candidate_detect(PWThreadData* data, int tid)
 	safe_malloc(read1, char, MAX_SEQ_SIZE);
 	safe_malloc(read2, char, MAX_SEQ_SIZE);
 	safe_malloc(subject, char, MAX_SEQ_SIZE);
-	SeedingBK* sbk = new SeedingBK(data->reference->curr);
-	Candidate candidates[MAXC];
+	SeedingBK* sbk = new SeedingBK();
+	CandidateHeap candidate_heap(data->options->num_candidates);
+	Candidate* candidates = candidate_heap.list;
 	int num_candidates = 0;
 	r_assert(data->ec_results);
 	ExtensionCandidate* eclist = data->ec_results[tid];
 	int nec = 0;
 	ExtensionCandidate ec;
+	PWStats* stats = data->stats + tid;
 
-	int rid, Lid, Rid;
-	while (1)
+	volume_t* reads;
+	int rid, vid, Lid, Rid;
+	while (get_next_chunk_reads(data, reads, vid, Lid, Rid))
 	{
-		get_next_chunk_reads(data, Lid, Rid);
-		if (Lid >= data->reads->num_reads) break;
-	for (rid = Lid; rid < Rid; ++rid)
-	{
-		int rsize = data->reads->offset_list->offset_list[rid].size;
-        if (rsize >= MAX_SEQ_SIZE) {
-            cout << "rsize = " << rsize << "\t" << MAX_SEQ_SIZE << endl;
-            abort();
-        }
-		extract_one_seq(data->reads, rid, read1);
-		reverse_complement(read2, read1, rsize);
-		int s;
-		int chain;
-		num_candidates = 0;
-		for (s = 0; s < 2; ++s)
-		{
-			if (s%2) { chain = REV; read = read2; }
-			else { chain = FWD; read = read1; }
-			int num_segs = seeding(read, rsize, data->ridx, sbk);
-			num_candidates = get_candidates(data->reference, 
-											sbk, 
-											num_segs, 
-											rid + data->reads->start_read_id, 
-											rsize, 
-											chain, 
-											candidates, 
-											num_candidates); 
-		}
-		
-		for (s = 0; s < num_candidates; ++s)
+		for (rid = Lid; rid < Rid; ++rid)
 		{
-			int qstart = candidates[s].loc2;
-			int sstart = candidates[s].loc1;
-			if (qstart && sstart)
+			int rsize = reads->offset_list->offset_list[rid].size;
+            if (rsize >= MAX_SEQ_SIZE) {
+                cout << "rsize = " << rsize << "\t" << MAX_SEQ_SIZE << endl;
+                abort();
+            }
+			extract_one_seq(reads, rid, read1);
+			reverse_complement(read2, read1, rsize);
+			++stats->reads;
+			int s;
+			int chain;
+			candidate_heap.clear();
+			for (s = 0; s < 2; ++s)
 			{
-				qstart += kmer_size / 2;
-				sstart += kmer_size / 2;
+				if (s%2) { chain = REV; read = read2; }
+				else { chain = FWD; read = read1; }
+				double t = pw_clock();
+				int num_segs = seeding(read, rsize, data->ridx, sbk, stats);
+				double t1 = pw_clock();
+				stats->seeding_time += t1 - t;
+				get_candidates(data->reference, 
+												sbk, 
+												num_segs, 
+												rid + reads->start_read_id, 
+												rsize, 
+												chain, 
+												&candidate_heap,
+												stats); 
+				stats->candidate_time += pw_clock() - t1;
 			}
-			int qdir = candidates[s].chain;
-			int sdir = FWD;
-			int qid = rid + data->reads->start_read_id;
-			int sid = candidates[s].readno;
-			int score = candidates[s].score;
+			num_candidates = candidate_heap.sort();
+			stats->candidates += num_candidates;
 			
-			ec.qid = qid;
-			ec.qdir = qdir;
-			ec.qext = qstart;
-			ec.sid = sid;
-			ec.sdir = sdir;
-			ec.sext = sstart;
-			ec.score = score;
-			ec.qsize = rsize;
-			ec.ssize = data->reference->offset_list->offset_list[sid - data->reference->start_read_id].size;
-            if (ec.qdir == REV) ec.qext = ec.qsize - 1 - ec.qext;
-            if (ec.sdir == REV) ec.sext = ec.ssize - 1 - ec.sext;
-			eclist[nec] = ec;
-			++nec;
-			if (nec == PWThreadData::kResultListSize)
+			for (s = 0; s < num_candidates; ++s)
 			{
-				pthread_mutex_lock(&data->result_write_lock);
-				for (int i = 0; i < nec; ++i) (*data->out) << eclist[i];
-				nec = 0;
-				pthread_mutex_unlock(&data->result_write_lock);
+				int qstart = candidates[s].loc2;
+				int sstart = candidates[s].loc1;
+				if (qstart && sstart)
+				{
+					qstart += kmer_size / 2;
+					sstart += kmer_size / 2;
+				}
+				int qdir = candidates[s].chain;
+				int sdir = FWD;
+				int qid = rid + reads->start_read_id;
+				int sid = candidates[s].readno;
+				int score = candidates[s].score;
+				
+				ec.qid = qid;
+				ec.qdir = qdir;
+				ec.qext = qstart;
+				ec.sid = sid;
+				ec.sdir = sdir;
+				ec.sext = sstart;
+				ec.score = score;
+				ec.qsize = rsize;
+				ec.ssize = data->reference->offset_list->offset_list[sid - data->reference->start_read_id].size;
+                if (ec.qdir == REV) ec.qext = ec.qsize - 1 - ec.qext;
+                if (ec.sdir == REV) ec.sext = ec.ssize - 1 - ec.sext;
+				eclist[nec] = ec;
+				++nec;
+				if (nec == PWThreadData::kResultListSize) write_results(data, stats, eclist, nec, print_candidate_list);
 			}
 		}
-	}
+		end_chunk_reads(data, vid);
 	}
 	
-	if (nec)
-	{
-		pthread_mutex_lock(&data->result_write_lock);
-		for (int i = 0; i < nec; ++i) (*data->out) << eclist[i];
-		nec = 0;
-		pthread_mutex_unlock(&data->result_write_lock);
-	}
+	if (nec) write_results(data, stats, eclist, nec, print_candidate_list);
 	
 	safe_free(read1);
 	safe_free(read2);
@@ -832,13 +1099,62 @@ multi_thread_func(void* p)
 	return NULL;
 }
 
+// the counters of all threads, with the options they depend on
+static void
+dump_pw_stats(const char* stats_name, options_t* options, const int rvid, const int svid, const int evid, 
+			  PWStats* thread_stats, const double wall_time)
+{
+	PWStats st;
+	for (int i = 0; i < options->num_threads; ++i) st.add(thread_stats[i]);
+	FILE* out = fopen(stats_name, "w");
+	if (!out) { LOG(stderr, "failed to open file \'%s\'.", stats_name); return; }
+	fprintf(out, "{\n");
+	fprintf(out, "  \"reference_volume\": %d,\n", rvid);
+	fprintf(out, "  \"query_volumes\": [%d, %d],\n", svid, evid);
+	fprintf(out, "  \"task\": \"%s\",\n", options->task == TASK_SEED ? "seed" : "align");
+	fprintf(out, "  \"threads\": %d,\n", options->num_threads);
+	fprintf(out, "  \"num_candidates\": %d,\n", options->num_candidates);
+	fprintf(out, "  \"min_kmer_match\": %d,\n", options->min_kmer_match);
+	fprintf(out, "  \"min_align_size\": %d,\n", options->min_align_size);
+	fprintf(out, "  \"kmer_size\": %d,\n", options->kmer_size);
+	fprintf(out, "  \"minimizer_window\": %d,\n", options->minimizer_window);
+	fprintf(out, "  \"wall_time\": %.3f,\n", wall_time);
+	fprintf(out, "  \"counters\": {\n");
+	fprintf(out, "    \"reads\": %lld,\n", (long long)st.reads);
+	fprintf(out, "    \"kmers\": %lld,\n", (long long)st.kmers);
+	fprintf(out, "    \"seeds\": %lld,\n", (long long)st.seeds);
+	fprintf(out, "    \"segments\": %lld,\n", (long long)st.segments);
+	fprintf(out, "    \"segments_scored\": %lld,\n", (long long)st.segments_scored);
+	fprintf(out, "    \"candidates\": %lld,\n", (long long)st.candidates);
+	fprintf(out, "    \"alignments\": %lld,\n", (long long)st.alignments);
+	fprintf(out, "    \"accepted\": %lld,\n", (long long)st.accepted);
+	fprintf(out, "    \"records\": %lld,\n", (long long)st.records);
+	fprintf(out, "    \"bytes_written\": %lld\n", (long long)st.bytes_written);
+	fprintf(out, "  },\n");
+	fprintf(out, "  \"times\": {\n");
+	fprintf(out, "    \"seeding\": %.3f,\n", st.seeding_time);
+	fprintf(out, "    \"candidates\": %.3f,\n", st.candidate_time);
+	fprintf(out, "    \"alignment\": %.3f,\n", st.align_time);
+	fprintf(out, "    \"containment\": %.3f,\n", st.containment_time);
+	fprintf(out, "    \"output\": %.3f,\n", st.output_time);
+	fprintf(out, "    \"lock_wait\": %.3f\n", st.lock_wait_time);
+	fprintf(out, "  }\n");
+	fprintf(out, "}\n");
+	fclose(out);
+	LOG(stderr, "%lld reads, %lld candidates, %lld alignments (%lld accepted), %lld results; stats are written to \'%s\'", 
+		(long long)st.reads, (long long)st.candidates, (long long)st.alignments, (long long)st.accepted, (long long)st.records, stats_name);
+}
+
 void
-process_one_volume(options_t* options, const int svid, const int evid, volume_names_t* vn, ostream* out)
+process_one_volume(options_t* options, const int rvid, const int svid, const int evid, volume_names_t* vn, ostream* out, const char* stats_name)
 {
-	MAXC = options->num_candidates;
 	output_gapped_start_point = options->output_gapped_start_point;
+	output_binary = options->output_binary;
 	min_align_size = options->min_align_size;
 	min_kmer_match = options->min_kmer_match;
+	kmer_size = options->kmer_size;
+	minimizer_window = options->minimizer_window;
+	seed_step = minimizer_window ? 1 : BC;
 	
 	if (options->tech == TECH_PACBIO) {
 		ddfs_cutoff = ddfs_cutoff_pacbio;
@@ -850,33 +1166,34 @@ process_one_volume(options_t* options, const int svid, const int evid, volume_na
 		ERROR("TECH must be either %d or %d", TECH_PACBIO, TECH_NANOPORE);
 	}
 	
-	const char* ref_name = get_vol_name(vn, svid);
+	const char* ref_name = get_vol_name(vn, rvid);
 	volume_t* ref = load_volume(ref_name);
-	ref_index* ridx = create_ref_index(ref, kmer_size, options->num_threads);
+	char ridx_name[1024];
+	generate_ref_index_file_name(ref_name, ridx_name);
+	ref_index* ridx = load_ref_index(ridx_name, ref, kmer_size, minimizer_window);
+	if (!ridx)
+	{
+		ridx = create_ref_index(ref, kmer_size, minimizer_window, options->num_threads);
+		dump_ref_index(ridx_name, ridx, ref, kmer_size);
+	}
+	Timer timer;
+	timer.go();
+	PWThreadData* data = new PWThreadData(options, ref, ridx, out, vn, svid, evid);
 	pthread_t tids[options->num_threads];
-	char volume_process_info[1024];;
-	int vid, tid;
-	for(vid = svid; vid < evid; ++vid)
+	int tid;
+	for (tid = 0; tid < options->num_threads; ++tid)
 	{
-		sprintf(volume_process_info, "process volume %d", vid);
-		DynamicTimer dtimer(volume_process_info);
-		const char* read_name = get_vol_name(vn, vid);
-		LOG(stderr, "processing %s\n", read_name);
-		volume_t* read = load_volume(read_name);
-		PWThreadData* data = new PWThreadData(options, ref, read, ridx, out);
-		for (tid = 0; tid < options->num_threads; ++tid)
+		int err_code = pthread_create(tids + tid, NULL, multi_thread_func, (void*)data);
+		if (err_code)
 		{
-			int err_code = pthread_create(tids + tid, NULL, multi_thread_func, (void*)data);
-			if (err_code)
-			{
-				LOG(stderr, "Error: return code is %d\n", err_code);
-				abort();
-			}
+			LOG(stderr, "Error: return code is %d\n", err_code);
+			abort();
 		}
-		for (tid = 0; tid < options->num_threads; ++tid) pthread_join(tids[tid], NULL);
-		read = delete_volume_t(read);
-		delete data;
 	}
+	for (tid = 0; tid < options->num_threads; ++tid) pthread_join(tids[tid], NULL);
+	timer.stop();
+	dump_pw_stats(stats_name, options, rvid, svid, evid, data->stats, timer.elapsed());
+	delete data;
 	ref = delete_volume_t(ref);
 	ridx = destroy_ref_index(ridx);
 }
@@ -1,12 +1,14 @@
 #ifndef PW_IMPL_H
 #define PW_IMPL_H
 
+#include <cstring>
 #include <iostream>
 
 #include "../common/alignment.h"
 #include "../common/packed_db.h"
 #include "../common/lookup_table.h"
 
+#define KMER_SIZE	13
 #define RM 			100000
 #define DN 			500
 #define BC 			10
@@ -14,56 +16,180 @@
 #define SI 			41
 #define CHUNK_SIZE 	500
 #define ZV 			2000
-#define MUL_ZV(a) 	((a)*ZV)
+#define MUL_ZV(a) 	((idx_t)(a)*ZV)
 #define DIV_ZV(a) 	((a)/ZV)
 #define MOD_ZV(a) 	((a)%ZV)
 
 struct candidate_save
 {
-    int loc1,loc2,left1,left2,right1,right2,score,num1,num2,readno,readstart;
+    int loc1,loc2,left1,left2,right1,right2,score,num1,num2,readno;
+    idx_t readstart;
+    // order in which the candidate was found, the earlier one wins a tie
+    int seq;
     char chain;
 };
 
 typedef candidate_save Candidate;
 
+// The best max_size candidates of a read. Once the list is full it is kept as
+// a heap whose top is the worst of them, so a better candidate replaces it in
+// O(log max_size) instead of shifting the sorted list.
+struct CandidateHeap
+{
+	candidate_save* list;
+	int size, max_size;
+	int num_pushed;
+	
+	CandidateHeap(const int max_candidates);
+	~CandidateHeap();
+	void clear() { size = 0; num_pushed = 0; }
+	void push(candidate_save& c);
+	// sorts the candidates, the best first, and returns their number
+	int sort();
+};
+
 struct Back_List
 {
-    short score,loczhi[SM],seedno[SM],seednum;
+    short score,loczhi[SM];
+    int seedno[SM],seednum;
     int index;
 };
 
+// Counters and timers of the stages of seeding and alignment, kept per thread
+// and merged into a JSON report when a reference volume is done. Times are
+// summed over the threads, in seconds.
+struct PWStats
+{
+	idx_t reads;
+	// query k-mers looked up and the reference positions they hit
+	idx_t kmers;
+	idx_t seeds;
+	// segments of ZV bases hit and those scored by find_location
+	idx_t segments;
+	idx_t segments_scored;
+	idx_t candidates;
+	idx_t alignments;
+	idx_t accepted;
+	// results that survive the containment check and are written
+	idx_t records;
+	idx_t bytes_written;
+	double seeding_time;
+	double candidate_time;
+	double align_time;
+	double containment_time;
+	double output_time;
+	double lock_wait_time;
+	
+	PWStats() { memset(this, 0, sizeof(PWStats)); }
+	void add(const PWStats& s);
+};
+
+// Loads a query volume in the background while the previous one is aligned.
+class PWVolumeLoader
+{
+public:
+	PWVolumeLoader() : volume_(NULL), running_(false), num_loaded_(0), load_time_(0.0), stall_time_(0.0) {}
+	~PWVolumeLoader() { volume_t* v = wait(); if (v) delete_volume_t(v); }
+	void start(const char* vol_name);
+	volume_t* wait();
+	// reports how much of the loading time was hidden behind alignment
+	void report();
+	
+private:
+	static void* load_func(void* arg);
+	
+private:
+	const char* vol_name_;
+	volume_t* volume_;
+	pthread_t tid_;
+	bool running_;
+	double last_load_time_;
+	int num_loaded_;
+	double load_time_;
+	double stall_time_;
+};
+
+// Shared by the workers of a reference volume for all of its query volumes.
+// Chunks of reads are handed out across volume boundaries: once every chunk of
+// a volume is taken, the next (prefetched) volume is opened, and a volume is
+// deleted when its last chunk is done.
 struct PWThreadData
 {
 	options_t*				options;
 	int 					used_thread_id;
 	pthread_mutex_t 		id_lock;
 	volume_t* 				reference;
-	volume_t* 				reads;
 	ref_index* 				ridx;
 	std::ostream*			out;	
 	M4Record** 				m4_results;
 	ExtensionCandidate**	ec_results;
 	static const int		kResultListSize = 10000;
 	pthread_mutex_t			result_write_lock;
+	PWStats*				stats;
+	// query volumes [svid, evid), curr_vid is the one chunks are taken from
+	volume_names_t*			vn;
+	int						svid, evid;
+	int						curr_vid;
 	int						next_processed_id;
+	volume_t**				volumes;
+	int*					active_chunks;
+	Timer*					volume_timers;
+	PWVolumeLoader			loader;
 	pthread_mutex_t			read_retrieve_lock;
 	
-	PWThreadData(options_t* opt, volume_t* ref, volume_t* rd, ref_index* idx, std::ostream* o);
+	PWThreadData(options_t* opt, volume_t* ref, ref_index* idx, std::ostream* o, volume_names_t* names, const int sv, const int ev);
 	~PWThreadData();
 };
 
+// Seed hits of a read, bucketed by reference segments of ZV bases. Only the
+// segments that are hit get a bucket, which is found through an open
+// addressing table, so the memory follows the hits of a read instead of the
+// size of the reference volume.
 struct SeedingBK
 {
+	// segment and score of each bucket, in the order the segments were hit
 	int* index_list;
 	short* index_score;
 	Back_List* database;
+	int num_buckets, max_buckets;
+	// bucket of a segment, -1 for an empty slot
+	int* table;
+	int table_bits;
+	// where a bucket is in the table
+	int* table_pos;
+	// stands for every segment without hits, its score stays 0
+	Back_List empty;
 	int* kmer_ids;
+	int* kmer_pos;
 	
-	SeedingBK(const int ref_size);
+	SeedingBK();
 	~SeedingBK();
+	
+	unsigned slot_of(const int seg_id) const
+	{
+		return ((unsigned)seg_id * 2654435761U) >> (32 - table_bits);
+	}
+	Back_List* find(const int seg_id)
+	{
+		const unsigned mask = (1U << table_bits) - 1;
+		for (unsigned p = slot_of(seg_id); ; p = (p + 1) & mask)
+		{
+			const int b = table[p];
+			if (b == -1) return &empty;
+			if (index_list[b] == seg_id) return database + b;
+		}
+	}
+	// adds a bucket for seg_id if it has none
+	Back_List* get(const int seg_id);
+	void clear();
+	
+private:
+	void rehash(const int bits);
 };
 
+// align the reads of volumes [svid, evid) against reference volume rvid,
+// the counters of the run are written to stats_name as JSON
 void
-process_one_volume(options_t* options, const int svid, const int evid, volume_names_t* vn, std::ostream* out);
+process_one_volume(options_t* options, const int rvid, const int svid, const int evid, volume_names_t* vn, std::ostream* out, const char* stats_name);
 
 #endif // PW_IMPL_H
@@ -11,6 +11,11 @@ static const int kDefaultAlignSizePacbio = 2000;
 static const int kDefaultAlignSizeNanopore = 500;
 static const int kDefaultKmerMatchPacbio = 4;
 static const int kDefaultKmerMatchNanopore = 2;
+static const int kDefaultKmerSize = 13;
+static const int kMinKmerSize = 10;
+static const int kMaxKmerSize = 14;
+static const int kMaxMinimizerWindow = 256;
+static const int kDefaultVolumeSize = 2140;
 
 void
 print_options(options_t* options)
@@ -25,6 +30,12 @@ print_options(options_t* options)
 	LOG(stderr, "min block score\t%d", options->min_kmer_match);
 	LOG(stderr, "output gapped start\t%c", options->output_gapped_start_point ? 'Y' : 'N'); 
 	LOG(stderr, "tech\t%d", options->tech);
+	LOG(stderr, "shared working folder\t%c", options->shared_wrk_dir ? 'Y' : 'N');
+	LOG(stderr, "aligner\t%d", options->aligner);
+	LOG(stderr, "binary output\t%c", options->output_binary ? 'Y' : 'N');
+	LOG(stderr, "kmer size\t%d", options->kmer_size);
+	LOG(stderr, "minimizer window\t%d", options->minimizer_window);
+	LOG(stderr, "volume size\t%lld", (long long)options->volume_size);
 }
 
 void
@@ -39,6 +50,12 @@ init_options(options_t* options, int tech)
     options->num_candidates = 100;
     options->output_gapped_start_point = 0;
 	options->tech = tech;
+	options->shared_wrk_dir = 0;
+	options->aligner = ALIGNER_DEFAULT;
+	options->output_binary = 0;
+	options->kmer_size = kDefaultKmerSize;
+	options->minimizer_window = 0;
+	options->volume_size = kDefaultVolumeSize * 1000000LL;
 	
 	if (tech == TECH_PACBIO) {
 		options->min_align_size = kDefaultAlignSizePacbio;
@@ -53,7 +70,7 @@ void print_usage(const char* prog)
 {
 	fprintf(stderr, "\n\n");
 	fprintf(stderr, "usage:\n");
-	fprintf(stderr, "%s [-j task] [-d dataset] [-o output] [-w working dir] [-t threads] [-n candidates] [-g 0/1]", prog);
+	fprintf(stderr, "%s [-j task] [-d dataset] [-o output] [-w working dir] [-t threads] [-n candidates] [-g 0/1] [-s 0/1] [-e 0/1] [-b 0/1] [-l kmer size] [-m window] [-v volume size]", prog);
 	fprintf(stderr, "\n\n");
 	fprintf(stderr, "options:\n");
 	fprintf(stderr, "-j <integer>\tjob: %d = seeding, %d = align\n\t\tdefault: %d\n", TASK_SEED, TASK_ALN, TASK_ALN);
@@ -68,6 +85,14 @@ void print_usage(const char* prog)
 	fprintf(stderr, "Default: %d if x = %d, %d if x = %d\n", kDefaultKmerMatchPacbio, TECH_PACBIO, kDefaultKmerMatchNanopore, TECH_NANOPORE);
 	fprintf(stderr, "-g <0/1>\twhether print gapped extension start point, 0 = no, 1 = yes\n\t\tDefault: 0\n");
 	fprintf(stderr, "-x <0/x>\tsequencing technology: 0 = pacbio, 1 = nanopore\n\t\tDefault: 0\n");
+	fprintf(stderr, "-s <0/1>\tshare the working folder with other %s processes, 0 = no, 1 = yes\n\t\t", prog);
+	fprintf(stderr, "if yes, volume pairs are claimed through lock files so that several nodes can work on them together\n\t\tDefault: 0\n");
+	fprintf(stderr, "-e <0/1>\tgapped extension aligner: %d = diff aligner if x = %d, xdrop aligner if x = %d; %d = bit-vector aligner\n\t\tDefault: %d\n", 
+			ALIGNER_DEFAULT, TECH_PACBIO, TECH_NANOPORE, ALIGNER_BITVEC, ALIGNER_DEFAULT);
+	fprintf(stderr, "-b <0/1>\toutput format: 0 = text, 1 = binary record stream (use 'mecat2m4 view' to convert it to text)\n\t\tDefault: 0\n");
+	fprintf(stderr, "-l <integer>\tsize of the indexed kmers, %d to %d\n\t\tDefault: %d\n", kMinKmerSize, kMaxKmerSize, kDefaultKmerSize);
+	fprintf(stderr, "-m <integer>\tminimizer window: 0 = index every kmer of the reference, w > 0 = index and match only the minimizers of every w consecutive kmers\n\t\tDefault: 0\n");
+	fprintf(stderr, "-v <integer>\tmaximum number of bases in a volume, in millions\n\t\tDefault: %d\n", kDefaultVolumeSize);
 }
 
 int
@@ -88,8 +113,14 @@ parse_arguments(int argc, char* argv[], options_t* options)
 	int min_kmer_match = -1;
 	int output_gapped_start_point = -1;
 	int tech = TECH_PACBIO;
+	int shared_wrk_dir = -1;
+	int aligner = -1;
+	int output_binary = -1;
+	int kmer_size = -1;
+	int minimizer_window = -1;
+	int volume_size = -1;
     
-    while((opt_char = getopt(argc, argv, "j:d:o:w:t:n:g:x:a:k:")) != -1)
+    while((opt_char = getopt(argc, argv, "j:d:o:w:t:n:g:x:a:k:s:e:b:l:m:v:")) != -1)
     {
         switch(opt_char)
         {
@@ -137,6 +168,42 @@ parse_arguments(int argc, char* argv[], options_t* options)
 					ERROR("invalid argument to option 'x': %s", optarg);
 				}
 				break;
+			case 's':
+				if (optarg[0] == '0') {
+					shared_wrk_dir = 0;
+				} else if (optarg[0] == '1') {
+					shared_wrk_dir = 1;
+				} else {
+					LOG(stderr, "argument to option \'-s\' must be either \'0\' or \'1\'");
+					return 1;
+				}
+				break;
+			case 'e':
+				aligner = atoi(optarg);
+				break;
+			case 'b':
+				if (optarg[0] == '0') {
+					output_binary = 0;
+				} else if (optarg[0] == '1') {
+					output_binary = 1;
+				} else {
+					LOG(stderr, "argument to option \'-b\' must be either \'0\' or \'1\'");
+					return 1;
+				}
+				break;
+			case 'l':
+				kmer_size = atoi(optarg);
+				break;
+			case 'm':
+				minimizer_window = atoi(optarg);
+				break;
+			case 'v':
+				volume_size = atoi(optarg);
+				if (volume_size < 1) {
+					LOG(stderr, "volume size (-v) must be > 0, not %s.", optarg);
+					return 1;
+				}
+				break;
             case '?':
                 err_char = (char)optopt;
                 LOG(stderr, "unrecognised option \'%c\'", err_char);
@@ -160,6 +227,12 @@ parse_arguments(int argc, char* argv[], options_t* options)
 	if (min_align_size != -1) options->min_align_size = min_align_size;
 	if (min_kmer_match != -1) options->min_kmer_match = min_kmer_match;
 	if (output_gapped_start_point != -1) options->output_gapped_start_point = output_gapped_start_point;
+	if (shared_wrk_dir != -1) options->shared_wrk_dir = shared_wrk_dir;
+	if (aligner != -1) options->aligner = aligner;
+	if (output_binary != -1) options->output_binary = output_binary;
+	if (kmer_size != -1) options->kmer_size = kmer_size;
+	if (minimizer_window != -1) options->minimizer_window = minimizer_window;
+	if (volume_size != -1) options->volume_size = volume_size * 1000000LL;
 	
 	if (options->task != TASK_SEED && options->task != TASK_ALN)
 	{
@@ -192,6 +265,21 @@ parse_arguments(int argc, char* argv[], options_t* options)
         LOG(stderr, "number of candidates must be > 0.");
         ret = 1;
     }
+    else if (options->aligner != ALIGNER_DEFAULT && options->aligner != ALIGNER_BITVEC)
+    {
+        LOG(stderr, "aligner (-e) must be %d or %d, not %d.", ALIGNER_DEFAULT, ALIGNER_BITVEC, options->aligner);
+        ret = 1;
+    }
+    else if (options->kmer_size < kMinKmerSize || options->kmer_size > kMaxKmerSize)
+    {
+        LOG(stderr, "kmer size (-l) must be between %d and %d, not %d.", kMinKmerSize, kMaxKmerSize, options->kmer_size);
+        ret = 1;
+    }
+    else if (options->minimizer_window < 0 || options->minimizer_window > kMaxMinimizerWindow)
+    {
+        LOG(stderr, "minimizer window (-m) must be between 0 and %d, not %d.", kMaxMinimizerWindow, options->minimizer_window);
+        ret = 1;
+    }
 
     if (ret) return ret;
 
@@ -6,6 +6,9 @@
 #define TASK_SEED 0
 #define TASK_ALN  1
 
+#define ALIGNER_DEFAULT	0
+#define ALIGNER_BITVEC	1
+
 typedef struct
 {
 	int task;
@@ -18,6 +21,12 @@ typedef struct
 	int			min_kmer_match;
     int         output_gapped_start_point;
 	int 		tech;
+	int			shared_wrk_dir;
+	int			aligner;
+	int			output_binary;
+	int			kmer_size;
+	int			minimizer_window;
+	idx_t		volume_size;
 } options_t;
 
 void
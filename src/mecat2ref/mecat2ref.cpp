@@ -9,9 +9,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <dirent.h>
-#define RM 100000
 
 #include "output.h"
+#include "mecat2ref_index.h"
 #include "../common/defs.h"
 
 static const char* prog_name = NULL;
@@ -66,6 +66,55 @@ void print_usage()
 	fprintf(stderr, "-b <integer>\toutput the best b alignments\n\t\tdefault: %d\n", kDefaultNumOutput);
 	fprintf(stderr, "-m <0/1/2>\toutput format: 0 = ref, 1 = m4, 2 = sam\n\t\tdefault: %d\n", kDefaultOutputFormat);
 	fprintf(stderr, "-x <0/1>\tsequencing technology: 0 = pacbio, 1 = nanopore\n\t\tdefault: %d\n", kDefaultTech);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "%s index [-r reference] [-o index]\n", prog_name);
+	fprintf(stderr, "\tbuilds the reference index once, -r of a mapping run then takes either the index\n");
+	fprintf(stderr, "\tor the FASTA file, whose index is used if it is found at the default name\n");
+	fprintf(stderr, "-r <string>\treference file name\n");
+	fprintf(stderr, "-o <string>\tindex file name\n\t\tdefault: <reference>.mri\n");
+}
+
+int
+build_ref_index(int argc, char* argv[])
+{
+	const char* reference = NULL;
+	const char* output = NULL;
+	int opt_char;
+	opterr = 0;
+	while((opt_char = getopt(argc, argv, "r:o:")) != -1)
+	{
+		switch(opt_char)
+		{
+			case 'r':
+				reference = optarg;
+				break;
+			case 'o':
+				output = optarg;
+				break;
+			default:
+				fprintf(stderr, "Error: unrecogised option or missing argument \'%c\'\n", (char)optopt);
+				print_usage();
+				return EXIT_FAILURE;
+		}
+	}
+	if (!reference)
+	{
+		fprintf(stderr, "Error: reference must be specified\n");
+		print_usage();
+		return EXIT_FAILURE;
+	}
+	
+	char path[2048];
+	if (!output)
+	{
+		generate_mr_index_file_name(reference, path);
+		output = path;
+	}
+	mr_index_t* idx = create_mr_index(reference, MR_INDEX_KMER_SIZE);
+	dump_mr_index(idx, output);
+	destroy_mr_index(idx);
+	fprintf(stderr, "reference index: %s\n", output);
+	return EXIT_SUCCESS;
 }
 
 int
@@ -174,98 +223,14 @@ param_read_t(int argc, char* argv[], meap_ref_options* options)
     return ret;
 }
 
-int str2num(char *str)
-{
-
-    int sum = 0, i;
-    char ch;
-    i = 0;
-    ch = str[i];
-    while (ch != '\0')
-    {
-        sum = sum * 10 + (ch - '0');
-        i++;
-        ch = str[i];
-    }
-    return (sum);
-}
-int chang_fastqfile(const char *fastaq, const char *fenfolder)
-{
-    FILE *fp, *ot;
-    int kk = 0,read_len;
-    char read_name[1000], onedata[RM], buff1[1000], buff2[RM], *fq, tempstr[200], *oq,ch;
-    sprintf(tempstr, "%s/0.fq", fenfolder);
-    fp = fopen(fastaq, "r");
-    ot = fopen(tempstr, "w");
-    fq = (char *)malloc(100000000);
-    setvbuf(fp, fq, _IOFBF, 100000000);
-    oq = (char *)malloc(100000000);
-    setvbuf(ot, oq, _IOFBF, 100000000);
-	int num_read_items;
-    ch=getc(fp);
-    if(ch=='>')
-    {
-        kk=0;
-        for (; ch!=EOF; ch=getc(fp))
-        {
-            if(ch=='>')
-            {
-                num_read_items = fscanf(fp,"%[^\n]s",read_name);
-				assert(num_read_items = 1);
-                if(kk>0)
-                {
-                    onedata[read_len]='\0';
-                    fprintf(ot, "%d\t\%d\t%s\n", kk-1,read_len,onedata);
-                    read_len=0;
-                    kk++;
-                }
-                else
-                {
-                    kk++;
-                    read_len=0;
-                }
-            }
-            else if(ch!='\n'&&ch!='\r')onedata[read_len++]=ch;
-        }
-        onedata[read_len]='\0';
-        fprintf(ot, "%d\t\%d\t%s\n", kk-1,read_len,onedata);
-    }
-    else
-    {
-        fseek(fp, 0L, SEEK_SET);
-        while (fscanf(fp, "%[^\n]s", read_name) != EOF && fscanf(fp, "%s\n", onedata) != EOF && fscanf(fp, "%[^\n]s", buff1) != EOF && fscanf(fp, "%s\n", buff2) != EOF)
-        {
-            read_len=strlen(onedata);
-            fprintf(ot, "%d\t%d\t%s\n", ++kk,read_len,onedata);
-        }
-    }
-    fclose(fp);
-    fclose(ot);
-    free(fq);
-    free(oq);
-    return (kk);
-
-}
-
-int firsttask(int argc, char *argv[])
+void parse_options(int argc, char *argv[], meap_ref_options* options)
 {
-	meap_ref_options* options = (meap_ref_options*)malloc(sizeof(meap_ref_options));
 	int flag = param_read_t(argc, argv, options);
 	if (flag == -1) { print_usage(); exit(1); }
-	
-    int readcount = chang_fastqfile(options->reads, options->wrk_dir);
-	char kkkkk[1024];
-    sprintf(kkkkk, "config.txt");
-    FILE* fileout = fopen(kkkkk, "w");
-    fprintf(fileout, "%s\n%s\n%s\n%s\n%d\t%d\n", options->wrk_dir, options->reference, options->reads, options->output, options->num_cores, readcount);
-    fclose(fileout);
-	int corenum = options->num_cores;
 	num_candidates = options->num_candidates;
 	num_output = options->num_output;
 	output_format = options->output_format;
 	tech = options->tech;
-	free(options);
-    return (corenum);
 }
 
 int cmp_temp_result_ptr(const void* a, const void* b)
@@ -355,7 +320,7 @@ output_query_results(fastaindexinfo* chr_idx, const int num_chr, TempResult** pp
 	}
 }
 
-int result_combine(int readcount, int filecount, char *workpath, char *outfile, char *fastaq, int main_argc, char* main_argv[])
+int result_combine(int filecount, const char *workpath, const char *outfile, int main_argc, char* main_argv[])
 {
 	char path[1024], buffer[1024];
 	sprintf(path, "%s/chrindex.txt", workpath);
@@ -433,82 +398,36 @@ int result_combine(int readcount, int filecount, char *workpath, char *outfile,
 	return 0;
 }
 
-long get_file_size(const char *path)
-{
-    long filesize = -1;
-    struct stat statbuff;
-    if(stat(path, &statbuff) < 0)
-    {
-        return filesize;
-    }
-    else
-    {
-        filesize = statbuff.st_size;
-    }
-    return filesize;
-}
-
-extern int meap_ref_impl_large(int, int, int);
-
-#define __run_system(cmd) \
-	do { \
-	int __rc_status = system(cmd); \
-	if (__rc_status != 0) { fprintf(stderr, "[%s, %u] system() error. Error code is %d.\n", __func__, __LINE__, __rc_status); exit(1); } \
-} while (0);
+extern int meap_ref_impl_large(const char*, const char*, const char*, int, int, int, int, FILE*);
 
 int main(int argc, char *argv[])
 {
 	prog_name = argv[0];
+	if (argc > 1 && strcmp(argv[1], "index") == 0) return build_ref_index(argc - 1, argv + 1);
 	
-    char cmd[300], outfile[200];
-    int corenum;
-    long filelength;
+    meap_ref_options options;
     struct timeval tpstart, tpend;
-    struct timeval mapstart, mapend;
     float timeuse;
-    char saved[150], fastqfile[150], fastafile[150], tempstr[150];
-    int  readcount;
-    FILE *fid1, *fid2;
+    char path[2048];
 
     gettimeofday(&tpstart, NULL);
-    corenum = firsttask(argc, argv);
-    gettimeofday(&tpend, NULL);
-    timeuse = 1000000 * (tpend.tv_sec - tpstart.tv_sec) + tpend.tv_usec - tpstart.tv_usec;
-    timeuse /= 1000000;
-    fid1 = fopen("config.txt", "r");
-	const char* read_results = NULL;
-    read_results = fgets(saved, 150, fid1);
-	assert(read_results);
-    saved[strlen(saved) - 1] = '\0';
-    read_results = fgets(fastafile, 150, fid1);
-	assert(read_results);
-    fastafile[strlen(fastafile) - 1] = '\0';
-    read_results = fgets(fastqfile, 150, fid1);
-	assert(read_results);
-    fastqfile[strlen(fastqfile) - 1] = '\0';
-    read_results = fgets(outfile, 150, fid1);
-	assert(read_results);
-    outfile[strlen(outfile) - 1] = '\0';
-    int num_read_items = fscanf(fid1, "%d %d\n", &corenum,&readcount);
-	assert(num_read_items == 2);
-    fclose(fid1);
-    filelength=get_file_size(fastafile);
-    gettimeofday(&mapstart, NULL);
-	meap_ref_impl_large(num_candidates, num_output, tech);
-    gettimeofday(&mapend, NULL);
-    timeuse = 1000000 * (mapend.tv_sec - mapstart.tv_sec) + mapend.tv_usec - mapstart.tv_usec;
-    timeuse /= 1000000;
+    parse_options(argc, argv, &options);
+    // the run log, next to the output so that runs do not overwrite each other's
+    sprintf(path, "%s.config", options.output);
+    FILE* run_log = fopen(path, "w");
+    if (!run_log) ERROR("failed to open file '%s' for writing", path);
+    fprintf(run_log, "%s\n%s\n%s\n%s\n", options.wrk_dir, options.reference, options.reads, options.output);
+    fprintf(run_log, "The number of threads: %d\n", options.num_cores);
+    int readcount = meap_ref_impl_large(options.wrk_dir, options.reference, options.reads, options.num_cores,
+                                        num_candidates, num_output, tech, run_log);
+    fprintf(run_log, "The number of reads: %d\n", readcount);
 
-    sprintf(tempstr,"%s/0.fq",saved);
-    result_combine(readcount, corenum, saved, outfile,tempstr, argc, argv);
+    result_combine(options.num_cores, options.wrk_dir, options.output, argc, argv);
     gettimeofday(&tpend, NULL);
     timeuse = 1000000 * (tpend.tv_sec - tpstart.tv_sec) + tpend.tv_usec - tpstart.tv_usec;
     timeuse /= 1000000;
-    fid2 = fopen("config.txt", "a");
-    fprintf(fid2, "The total Time : %f sec\n", timeuse);
-    fclose(fid2);
-    sprintf(cmd, "cp -r config.txt \"%s.config\"", outfile);
-    __run_system(cmd);
+    fprintf(run_log, "The total Time : %f sec\n", timeuse);
+    fclose(run_log);
 	
 	return EXIT_SUCCESS;
 }
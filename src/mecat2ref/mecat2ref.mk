@@ -6,12 +6,12 @@ ifeq "$(strip ${TARGET_DIR})" ""
 endif
 
 TARGET   := mecat2ref
-SOURCES  := mecat2ref.cpp mecat2ref_impl_large.cpp output.cpp mecat2ref_aux.cpp
+SOURCES  := mecat2ref.cpp mecat2ref_impl_large.cpp mecat2ref_index.cpp mecat2ref_reads.cpp output.cpp mecat2ref_aux.cpp
 
 SRC_INCDIRS  := . 
 
 TGT_LDFLAGS := -L${TARGET_DIR}
-TGT_LDLIBS  := -lmecat
+TGT_LDLIBS  := -lmecat -lz
 TGT_PREREQS := libmecat.a
 
 SUBMAKEFILES :=
@@ -3,6 +3,88 @@
 #include <algorithm>
 using namespace std;
 
+static void
+reset_block(Back_List* block)
+{
+	block->score = 0;
+	block->score2 = 0;
+	block->index = -1;
+}
+
+SeedBlockTable::SeedBlockTable()
+{
+	reset_block(&empty_);
+	rehash(1024);
+}
+
+void
+SeedBlockTable::rehash(const size_t num_slots)
+{
+	shift_ = 64;
+	for (size_t n = num_slots; n > 1; n >>= 1) --shift_;
+	slots_.assign(num_slots, -1);
+	for (size_t i = 0; i < ids_.size(); ++i)
+	{
+		const size_t s = find_slot(ids_[i]);
+		slots_[s] = i;
+		slot_of_[i] = s;
+	}
+}
+
+Back_List*
+SeedBlockTable::insert(const long bid)
+{
+	size_t s = find_slot(bid);
+	if (slots_[s] != -1) return &blocks_[slots_[s]];
+	
+	if (2 * (ids_.size() + 1) > slots_.size())
+	{
+		rehash(2 * slots_.size());
+		s = find_slot(bid);
+	}
+	slots_[s] = ids_.size();
+	slot_of_.push_back(s);
+	ids_.push_back(bid);
+	blocks_.push_back(Back_List());
+	reset_block(&blocks_.back());
+	return &blocks_.back();
+}
+
+void
+SeedBlockTable::clear()
+{
+	for (size_t i = 0; i < slot_of_.size(); ++i) slots_[slot_of_[i]] = -1;
+	blocks_.clear();
+	ids_.clear();
+	slot_of_.clear();
+}
+
+StringArena::~StringArena()
+{
+	for (size_t i = 0; i < blocks_.size(); ++i) delete[] blocks_[i];
+}
+
+char*
+StringArena::copy(const char* s)
+{
+	const size_t n = strlen(s) + 1;
+	while (cur_ < blocks_.size() && used_ + n > block_sizes_[cur_])
+	{
+		++cur_;
+		used_ = 0;
+	}
+	if (cur_ == blocks_.size())
+	{
+		const size_t size = max(kBlockSize, n);
+		blocks_.push_back(new char[size]);
+		block_sizes_.push_back(size);
+	}
+	char* p = blocks_[cur_] + used_;
+	memcpy(p, s, n);
+	used_ += n;
+	return p;
+}
+
 int find_location(int *t_loc,int *t_seedn,int *t_score,long *loc,int k,int *rep_loc,float len,int read_len1, double ddfs_cutoff)
 {
     int i,j,maxval=0,maxi,rep=0,lasti=0;
@@ -83,15 +165,13 @@ int find_location(int *t_loc,int *t_seedn,int *t_score,long *loc,int k,int *rep_
 }
 
 void
-extract_sequences(const char* raw_ref,
-				  const char* raw_read,
+extract_sequences(const mr_index_t* ref_index,
 				  const long ref_start,
 				  const int read_start,
 				  const int read_size,
 				  const long ref_size,
 				  long& left_ref_size,
 				  long& right_ref_size,
-				  vector<char>& qstr,
 				  vector<char>& tstr)
 {
 	long L1 = read_start, R1 = read_size - read_start;
@@ -99,35 +179,19 @@ extract_sequences(const char* raw_ref,
 	long L = min(L1, L2), R = min(R1, R2);
 	left_ref_size = min(L2, (long)(L * 1.2));
 	right_ref_size = min(R2, (long)(R * 1.2));
-	const u1_t* et = get_dna_encode_table();
 	
-	const char* rs = raw_ref + ref_start - left_ref_size;
-	const char* re = raw_ref + ref_start + right_ref_size;
-	tstr.clear();
-	for (const char* r = rs; r != re; ++r) {
-		u1_t c = *r;
-		c = et[c];
-		if (c > 3) c = 0;
-		tstr.push_back((char)c);
-	}
-	
-	qstr.clear();
-	for (int i = 0; i < read_size; ++i) {
-		u1_t c = raw_read[i];
-		c = et[c];
-		if (c > 3) c = 0;
-		qstr.push_back((char)c);
-	}
+	tstr.resize(left_ref_size + right_ref_size);
+	mr_index_extract(ref_index, ref_start - left_ref_size, ref_start + right_ref_size, (u1_t*)tstr.data());
 }
 
 bool extend_candidate(candidate_save& can,
 					  GapAligner* aligner,
-					  const char* raw_ref,
+					  const mr_index_t* ref_index,
 					  const long ref_size,
-					  const char* fwd_raw_read,
-					  const char* rev_raw_read,
-					  vector<char>& qstr,
+					  const char* fwd_read,
+					  const char* rev_read,
 					  vector<char>& tstr,
+					  StringArena* aln_strings,
 					  int read_name,
 					  int read_len,
 					  AlignInfo* alns,
@@ -135,21 +199,19 @@ bool extend_candidate(candidate_save& can,
 					  TempResult* trv,
 					  int& ntr)
 {
-	const char* raw_read = (can.chain == 'F') ? fwd_raw_read : rev_raw_read;
+	const char* read = (can.chain == 'F') ? fwd_read : rev_read;
 	int read_start = can.loc2;
 	long ref_start = can.loc1 - 1;
 	long left_ref_size, right_ref_size;
-	extract_sequences(raw_ref, 
-					  raw_read, 
+	extract_sequences(ref_index, 
 					  ref_start, 
 					  read_start,
 					  read_len, 
 					  ref_size, 
 					  left_ref_size, 
 					  right_ref_size, 
-					  qstr, 
 					  tstr);
-	if (aligner->go(qstr.data(), read_start, read_len, tstr.data(), left_ref_size, tstr.size(), 1000)) {
+	if (aligner->go(read, read_start, read_len, tstr.data(), left_ref_size, tstr.size(), 1000)) {
 
 		TempResult& r = trv[ntr++];
 		r.read_id = read_name;
@@ -160,8 +222,8 @@ bool extend_candidate(candidate_save& can,
 		r.qs = read_len;
 		r.sb = ref_start - left_ref_size + aligner->target_start();
 		r.se = ref_start - left_ref_size + aligner->target_end();
-		strcpy(r.qmap, aligner->query_mapped_string());
-		strcpy(r.smap, aligner->target_mapped_string());
+		r.qmap = aln_strings->copy(aligner->query_mapped_string());
+		r.smap = aln_strings->copy(aligner->target_mapped_string());
 
 		if (alns) {
 			alns[*naln].qoff = r.qb;
@@ -214,7 +276,7 @@ fill_clipped_candidate(Back_List* block,
 bool
 find_left_clipped_candidate(AlignInfo& aln,
 							candidate_save& can,
-						    Back_List* database,
+						    SeedBlockTable* database,
 						    int block_size,
 						    int read_size,
 						    int BC,
@@ -228,9 +290,10 @@ find_left_clipped_candidate(AlignInfo& aln,
 	Back_List* block = NULL;
 	long bid = -1;
 	for (--n2; n >= 0 && n2 >= 0; --n, --n2) {
-		if (database[n2].score2 > max_score) {
-			max_score = database[n2].score2;
-			block = database + n2;
+		Back_List* b = database->get(n2);
+		if (b->score2 > max_score) {
+			max_score = b->score2;
+			block = b;
 			bid = n2;
 		}
 	}
@@ -244,7 +307,7 @@ find_left_clipped_candidate(AlignInfo& aln,
 bool
 find_right_clipped_candidate(AlignInfo& aln,
 							 candidate_save& can,
-							 Back_List* database,
+							 SeedBlockTable* database,
 							 int block_size,
 							 int read_size,
 							 long ref_size,
@@ -260,9 +323,10 @@ find_right_clipped_candidate(AlignInfo& aln,
 	Back_List* block = NULL;
 	int k = aln.send / block_size + 1;
 	for (; n >= 0; --n, ++k) {
-		if (database[k].score2 > max_score) {
-			max_score = database[k].score2;
-			block = database + k;
+		Back_List* b = database->get(k);
+		if (b->score2 > max_score) {
+			max_score = b->score2;
+			block = b;
 			bid = k;
 		}
 	}
@@ -311,18 +375,18 @@ rescue_clipped_align(AlignInfo* alnv,
 					  TempResult* results,
 					  int& nresults,
 					  GapAligner* aligner,
-					  const char* raw_ref,
+					  const mr_index_t* ref_index,
 					  const long ref_size,
-					  const char* fwd_raw_read,
-					  const char* rev_raw_read,
-					  vector<char>& qstr,
+					  const char* fwd_read,
+					  const char* rev_read,
 					  vector<char>& tstr,
+					  StringArena* aln_strings,
 					  int read_name,
 					  int read_len,
 					  int block_size,
 					  int BC,
-					  Back_List* fwd_database, 
-					  Back_List* rev_database,
+					  SeedBlockTable* fwd_database, 
+					  SeedBlockTable* rev_database,
 					  double ddfs_cutoff)
 {
 	sort(alnv, alnv + naln);
@@ -361,16 +425,16 @@ rescue_clipped_align(AlignInfo* alnv,
 	candidate_save can;
 	for (int i = 0; i < n; ++i) {
 		if (alnv[i].parent_id != -1) continue;
-		Back_List* database = (alnv[i].qdir == 'F') ? fwd_database : rev_database;
+		SeedBlockTable* database = (alnv[i].qdir == 'F') ? fwd_database : rev_database;
 		if (alnv[i].prev_id == -1 && find_left_clipped_candidate(alnv[i], can, database, block_size, read_len, BC, ddfs_cutoff)) {
 			bool r = extend_candidate(can, 
 							 aligner, 
-							 raw_ref, 
+							 ref_index, 
 							 ref_size,
-							 fwd_raw_read, 
-							 rev_raw_read, 
-							 qstr, 
+							 fwd_read, 
+							 rev_read, 
 							 tstr, 
+							 aln_strings, 
 							 read_name, 
 							 read_len, 
 							 NULL, 
@@ -401,12 +465,12 @@ rescue_clipped_align(AlignInfo* alnv,
 		if (alnv[i].next_id == -1 && find_right_clipped_candidate(alnv[i], can, database, block_size, read_len, ref_size, BC, ddfs_cutoff)) {
 			bool r = extend_candidate(can, 
 									  aligner, 
-									  raw_ref, 
+									  ref_index, 
 									  ref_size,
-									  fwd_raw_read, 
-									  rev_raw_read, 
-									  qstr, 
+									  fwd_read, 
+									  rev_read, 
 									  tstr, 
+									  aln_strings, 
 									  read_name, 
 									  read_len, 
 									  NULL, 
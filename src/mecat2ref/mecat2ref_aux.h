@@ -4,6 +4,7 @@
 #include "../common/gapalign.h"
 #include "output.h"
 #include "mecat2ref_defs.h"
+#include "mecat2ref_index.h"
 #include <vector>
 
 struct AlignInfo
@@ -41,17 +42,77 @@ AlignInfoContained(const AlignInfo& a, const AlignInfo& b)
 	return r;
 }
 
+// The blocks of the reference hit by the seeds of one strand of a read, in the
+// order of their first hit. Seed voting used to keep a Back_List for every block
+// of the reference, this keeps one per block hit, so it scales with the read.
+class SeedBlockTable
+{
+public:
+	SeedBlockTable();
+	
+	int size() const { return ids_.size(); }
+	long block_id(const int i) const { return ids_[i]; }
+	Back_List* block(const int i) { return &blocks_[i]; }
+	// block bid, or a block of zero scores if no seed hit it, which must not be changed
+	Back_List* get(const long bid)
+	{
+		const int i = slots_[find_slot(bid)];
+		return i == -1 ? &empty_ : &blocks_[i];
+	}
+	// block bid, added with zero scores if no seed has hit it yet;
+	// this may move the other blocks
+	Back_List* insert(const long bid);
+	void clear();
+
+private:
+	size_t find_slot(const long bid) const
+	{
+		size_t s = ((uint64_t)bid * 0x9E3779B97F4A7C15ULL) >> shift_;
+		while (slots_[s] != -1 && ids_[slots_[s]] != bid) s = (s + 1) & (slots_.size() - 1);
+		return s;
+	}
+	void rehash(const size_t num_slots);
+
+private:
+	std::vector<Back_List> blocks_;
+	std::vector<long> ids_;
+	// open addressing, the index of a block in blocks_ or -1
+	std::vector<int> slots_;
+	std::vector<size_t> slot_of_;
+	int shift_;
+	Back_List empty_;
+};
+
+// Per-thread storage of the alignment strings of a read. It grows by blocks, so
+// the strings stored never move, and clear() keeps the blocks for the next read.
+class StringArena
+{
+public:
+	StringArena() : cur_(0), used_(0) {}
+	~StringArena();
+	char* copy(const char* s);
+	void clear() { cur_ = 0; used_ = 0; }
+
+private:
+	static const size_t kBlockSize = 1 << 20;
+	std::vector<char*> blocks_;
+	std::vector<size_t> block_sizes_;
+	size_t cur_;
+	size_t used_;
+};
+
 int 
 find_location(int *t_loc,int *t_seedn,int *t_score,long *loc,int k,int *rep_loc,float len,int read_len1, double ddfs_cutoff);
 
+// fwd_read and rev_read are the base codes (0 - 3) of the two strands of the read
 bool extend_candidate(candidate_save& can,
 					  GapAligner* aligner,
-					  const char* raw_ref,
+					  const mr_index_t* ref_index,
 					  const long ref_size,
-					  const char* fwd_raw_read,
-					  const char* rev_raw_read,
-					  std::vector<char>& qstr,
+					  const char* fwd_read,
+					  const char* rev_read,
 					  std::vector<char>& tstr,
+					  StringArena* aln_strings,
 					  int read_name,
 					  int read_len,
 					  AlignInfo* alns,
@@ -65,18 +126,18 @@ rescue_clipped_align(AlignInfo* alnv,
 					 TempResult* results,
 					 int& nresults,
 					 GapAligner* aligner,
-					 const char* raw_ref,
+					 const mr_index_t* ref_index,
 					 const long ref_size,
-					 const char* fwd_raw_read,
-					 const char* rev_raw_read,
-					 std::vector<char>& qstr,
+					 const char* fwd_read,
+					 const char* rev_read,
 					 std::vector<char>& tstr,
+					 StringArena* aln_strings,
 					 int read_name,
 					 int read_len,
 					 int block_size,
 					 int BC,
-					 Back_List* fwd_database, 
-					 Back_List* rev_database,
+					 SeedBlockTable* fwd_database, 
+					 SeedBlockTable* rev_database,
 					 double ddfs_cutoff);
 
 void
@@ -1,6 +1,8 @@
 #include "mecat2ref_defs.h"
 #include "output.h"
 #include "mecat2ref_aux.h"
+#include "mecat2ref_index.h"
+#include "mecat2ref_reads.h"
 #include "../common/diff_gapalign.h"
 #include "../common/xdrop_gapalign.h"
 
@@ -18,73 +20,112 @@ static pthread_t *thread;
 static int threadnum=2;
 static FILE **outfile;
 static pthread_mutex_t mutilock; 
-static int runnumber=0,runthreadnum=0, readcount,terminalnum;
-static int *countin;
-static long **databaseindex,*allloc,seqcount,sumcount;
+static int runthreadnum=0;
+static mr_index_t *ref_index;
+static long seqcount;
 static int seed_len;
-static char *REFSEQ;
-static char *savework,workpath[300],fastqfile[300];
-static ReadFasta *readinfo;
+static const char *workpath;
 
-static long get_file_size(const char *path)
+// A batch of reads on its way through the workers. Chunks of PLL reads are
+// handed out across batch boundaries: once every chunk of a batch is taken,
+// the next batch, which the reader has parsed in the meantime, is opened, and
+// a batch is closed when its last chunk is done.
+struct MappingBatch
 {
-    long filesize = -1;
-    struct stat statbuff;
-    if(stat(path, &statbuff) < 0)
-    {
-        return filesize;
-    }
-    else
+    ReadBatch *reads;
+    int id,num_chunks,next_chunk,active_chunks;
+    // the time the workers spent on its chunks and on waiting for it to be parsed
+    double busy_time,wait_time;
+    Timer timer;
+};
+
+static ReadBatchReader *read_stream;
+static MappingBatch *curr_batch;
+static int num_batches;
+static double total_busy_time;
+static bool reads_done;
+// chunk_lock is held while chunks are taken and batches opened, batch_lock
+// guards the counters of the open batches and the run log
+static pthread_mutex_t chunk_lock,batch_lock;
+static FILE *run_log;
+
+// A, C, G, T are 0 - 3, any other character c is 4 | (its code in the alignment),
+// which is the code of c if it is a lower case base and 0 (A) otherwise
+struct read_code_table
+{
+    u1_t codes[256];
+    read_code_table()
     {
-        filesize = statbuff.st_size;
+        const u1_t* et=get_dna_encode_table();
+        for(int c=0; c<256; c++)codes[c]=4|(et[c]<4?et[c]:0);
+        codes['A']=0;
+        codes['C']=1;
+        codes['G']=2;
+        codes['T']=3;
     }
-    return filesize;
-}
+};
 
-static unsigned short atcttrans(char c)
+// the codes of the read and of its reverse complement, other characters than ACGT are
+// not complemented. The reverse complement is built eight codes at a time.
+static void encode_read(const char *seq,int len,u1_t *fwd,u1_t *rev)
 {
-    if(c=='A')return 0;
-    else if(c=='T')return 1;
-    else if(c=='C')return 2;
-    else if(c=='G')return 3;
-    else return 4;
+    static const read_code_table table;
+    int i;
+    for(i=0; i<len; i++)fwd[i]=table.codes[(u1_t)seq[i]];
+    const uint64_t ones=0x0101010101010101ULL;
+    for(i=0; i+8<=len; i+=8)
+    {
+        uint64_t w;
+        memcpy(&w,fwd+len-8-i,sizeof(uint64_t));
+        w=__builtin_bswap64(w);
+        w^=((~w>>2)&ones)*3;
+        memcpy(rev+i,&w,sizeof(uint64_t));
+    }
+    for(; i<len; i++)
+    {
+        u1_t c=fwd[len-1-i];
+        rev[i]=c<4?(c^3):c;
+    }
 }
 
-static long sumvalue_x(int *intarry,int count)
+// the base codes of the alignment, eight at a time
+static void alignment_codes(const u1_t *codes,int len,char *s)
 {
-    long i,sumval=0;
-    for(i=0; i<count; i++)
+    const uint64_t mask=0x0303030303030303ULL;
+    int i;
+    for(i=0; i+8<=len; i+=8)
     {
-        if(intarry[i]>0&&intarry[i]<129)sumval=sumval+intarry[i];
-        else if(intarry[i]>128)intarry[i]=0;
+        uint64_t w;
+        memcpy(&w,codes+i,sizeof(uint64_t));
+        w&=mask;
+        memcpy(s+i,&w,sizeof(uint64_t));
     }
-    return(sumval);
+    for(; i<len; i++)s[i]=codes[i]&3;
 }
 
-static int transnum_buchang(char *seqm,int *value,int *endn,int len_str,int readnum,int BC)
+// the k-mers starting at every BC-th base of the read, -1 for those with other bases than ACGT
+static int sample_kmers(const u1_t *codes,int len_str,int readnum,int BC,int *value)
 {
-    int eit=0,temp;
-    int i,j,start,num;
-    num=(len_str-readnum)/BC+1;
-    *endn=(len_str-readnum)%BC;
-    //if((len_str%readnum)>0)num=num+1;
-    for(i=0; i<num; i++)
+    if(len_str<readnum)return(0);
+    const int num=(len_str-readnum)/BC+1;
+    const uint32_t mask=(1U<<(2*readnum))-1;
+    const int last=(num-1)*BC+readnum-1;
+    uint32_t eit=0;
+    int valid=0,next_end=readnum-1,i,k=0;
+    for(i=0; i<=last; i++)
     {
-        eit=0;
-        start=i*BC;
-        //if(i==num-1){eit=0;start=len_str-readnum;}
-        for(j=0; j<readnum; j++)
+        const u1_t c=codes[i];
+        if(c>3)valid=0;
+        else
         {
-            temp=atcttrans(seqm[start+j]);
-            if(temp==4)
-            {
-                eit=-1;
-                break;
-            }
-            eit=eit<<2;
-            eit=eit+temp;
+            eit=((eit<<2)|c)&mask;
+            valid++;
+        }
+        if(i==next_end)
+        {
+            value[k++]=valid>=readnum?(int)eit:-1;
+            next_end+=BC;
         }
-        value[i]=eit;
     }
     return(num);
 }
@@ -130,200 +171,110 @@ static void insert_loc(struct Back_List *spr,int loc,int seedn,float len)
 }
 
 
-static void creat_ref_index(char *fastafile)
+// waits for the next batch of the reader, NULL after the last one
+static MappingBatch* open_next_batch()
 {
-    unsigned int eit,temp;
-    int  indexcount=0,leftnum=0;
-    long length,count,i,start, rsize = 0;
-    FILE *fasta,*fastaindex;
-    char *seq,ch,nameall[200];
-    //
-    if(seed_len==14)indexcount=268435456;
-    else if(seed_len==13)indexcount=67108864;
-    else if(seed_len==12)indexcount=16777216;
-    else if(seed_len==11)indexcount=4194304;
-    else if(seed_len==10)indexcount=1048576;
-    else if(seed_len==9)indexcount=262144;
-    else if(seed_len==8)indexcount=65536;
-    else if(seed_len==7)indexcount=16384;
-    else if(seed_len==6)indexcount=4096;
-    leftnum=34-2*seed_len;
-    //read reference seq
-    length=get_file_size(fastafile);
-    fasta=fopen(fastafile, "r");
-    sprintf(nameall,"%s/chrindex.txt",workpath);
-    fastaindex=fopen(nameall,"w");
-
-    REFSEQ=(char *)malloc((length+1000)*sizeof(char));
-    seq=REFSEQ;
-    for (ch=getc(fasta),count=0; ch!=EOF; ch=getc(fasta))
-    {
-        if(ch=='>')
-        {
-            assert(fscanf(fasta,"%[^\n]s",nameall) == 1);
-			if (rsize) fprintf(fastaindex, "%ld\n", rsize);
-			rsize = 0;
-			for(i=0;i<strlen(nameall);i++)if(nameall[i]==' '||nameall[i]=='\t')break;
-			nameall[i]='\0';
-            fprintf(fastaindex,"%ld\t%s\t",count,nameall);
-        }
-        else if(ch!='\n'&&ch!='\r')
-        {
-            if(ch>'Z')ch=toupper(ch);
-            seq[count]=ch;
-            count=count+1;
-			++rsize;
-        }
-    }
-    fclose(fasta);
-	fprintf(fastaindex, "%ld\n", rsize);
-    fprintf(fastaindex,"%ld\t%s\n",count,"FileEnd");
-    seq[count]='\0';
-    fclose(fastaindex);
-    seqcount=count;
-    printf("%ld\n",seqcount);
-//printf("Constructing look-up table...\n");
-    countin=(int *)malloc((indexcount)*sizeof(int));
-    for(i=0; i<indexcount; i++)countin[i]=0;
-
-// Count the number
-    eit=0;
-    start=0;
-    for(i=0; i<seqcount; i++)
-    {
-        if(seq[i]=='N'||(temp=atcttrans(seq[i]))==4)
-        {
-            eit=0;
-            start=0;
-            continue;
-        }
-        temp=atcttrans(seq[i]);
-        if(start<seed_len-1)
-        {
-            eit=eit<<2;
-            eit=eit+temp;
-            start=start+1;
-        }
-        else if(start>=seed_len-1)
-        {
-            eit=eit<<2;
-            eit=eit+temp;
-            start=start+1;
-            countin[eit]=countin[eit]+1;
-            eit=eit<<leftnum;
-            eit=eit>>leftnum;
-        }
-    }
+    Timer timer;
+    timer.go();
+    ReadBatch *reads=read_stream->next();
+    timer.stop();
+    if(!reads)return(NULL);
+    MappingBatch *batch=new MappingBatch;
+    batch->reads=reads;
+    batch->id=++num_batches;
+    batch->num_chunks=(reads->reads.size()+PLL-1)/PLL;
+    batch->next_chunk=0;
+    batch->active_chunks=0;
+    batch->busy_time=0.0;
+    batch->wait_time=timer.elapsed();
+    batch->timer.go();
+    return(batch);
+}
 
+// utilization is the share of the thread time from the opening of the batch to
+// the end of its last chunk that was spent on its reads
+static void close_batch(MappingBatch *batch)
+{
+    batch->timer.stop();
+    const double wall=batch->timer.elapsed();
+    const double utilization=wall>0.0?100.0*batch->busy_time/(wall*threadnum):100.0;
+    fprintf(run_log,"batch %d: %d reads in %d chunks, %.2f secs, %.2f thread secs busy, utilization %.1f%%, %.2f secs waiting for the reads\n",
+            batch->id,(int)batch->reads->reads.size(),batch->num_chunks,wall,batch->busy_time,utilization,batch->wait_time);
+    fflush(run_log);
+    total_busy_time+=batch->busy_time;
+    delete batch->reads;
+    delete batch;
+}
 
-//Max_index
-    sumcount=sumvalue_x(countin,indexcount);
-    allloc=(long *)malloc(sumcount*sizeof(long));
-    databaseindex=(long **)malloc((indexcount)*sizeof(long*));
-//allocate memory
-    sumcount=0;
-    for(i=0; i<indexcount; i++)
+// returns the batch of the next chunk and its number in chunk, NULL if all reads are taken
+static MappingBatch* take_chunk(int *chunk)
+{
+    MappingBatch *batch=NULL;
+    pthread_mutex_lock(&chunk_lock);
+    while(!curr_batch&&!reads_done)
     {
-        if(countin[i]>0)
-        {
-            databaseindex[i]=allloc+sumcount;
-            sumcount=sumcount+countin[i];
-            countin[i]=0;
-        }
-        else databaseindex[i]=NULL;
+        curr_batch=open_next_batch();
+        if(!curr_batch)reads_done=true;
     }
-
-    // printf("xiao");//10834098
-
-//constructing the look-up table
-    eit=0;
-    start=0;
-    for(i=0; i<seqcount; i++)
+    if(curr_batch)
     {
-        if(seq[i]=='N'||(temp=atcttrans(seq[i]))==4)
-        {
-            eit=0;
-            start=0;
-            continue;
-        }
-        temp=atcttrans(seq[i]);
-        if(start<seed_len-1)
-        {
-            eit=eit<<2;
-            eit=eit+temp;
-            start=start+1;
-        }
-        else if(start>=seed_len-1)
-        {
-            eit=eit<<2;
-            eit=eit+temp;
-            start=start+1;
-
-            if(databaseindex[eit]!=NULL)
-            {
-                countin[eit]=countin[eit]+1;
-                databaseindex[eit][countin[eit]-1]=i+2-seed_len;
-            }
-            eit=eit<<leftnum;
-            eit=eit>>leftnum;
-        }
+        batch=curr_batch;
+        pthread_mutex_lock(&batch_lock);
+        *chunk=batch->next_chunk++;
+        ++batch->active_chunks;
+        pthread_mutex_unlock(&batch_lock);
+        if(batch->next_chunk==batch->num_chunks)curr_batch=NULL;
     }
+    pthread_mutex_unlock(&chunk_lock);
+    return(batch);
 }
 
+static void finish_chunk(MappingBatch *batch,double busy_time)
+{
+    pthread_mutex_lock(&batch_lock);
+    batch->busy_time+=busy_time;
+    --batch->active_chunks;
+    if(batch->active_chunks==0&&batch->next_chunk==batch->num_chunks)close_batch(batch);
+    pthread_mutex_unlock(&batch_lock);
+}
 
 static void reference_mapping(int threadint)
 {
     int cleave_num,read_len;
-    int mvalue[20000],flag_end;
-    long *leadarray,u_k,s_k,loc;
+    int flag_end;
+    long kmer_start,kmer_loc,u_k,s_k,loc;
     int count1=0,i,j,k,templong,read_name;
-    struct Back_List *database,*temp_spr,*temp_spr1;
-    int repeat_loc = 0,*index_list,*index_spr;
-    long location_loc[4],left_length1,right_length1,left_length2,right_length2,loc_list,start_loc;
-    short int *index_score,*index_ss;
+    struct Back_List *temp_spr,*temp_spr1;
+    SeedBlockTable *database;
+    int repeat_loc = 0;
+    long location_loc[4],left_length1,right_length1,left_length2,right_length2,loc_list,start_loc,bid;
+    vector<short> *index_score;
     int temp_list[200],temp_seedn[200],temp_score[200];
-    int localnum,read_i,read_end,fileid;
+    int localnum,read_i,read_end;
+    MappingBatch *batch;
+    const ReadFasta *readinfo;
+    Timer chunk_timer;
     int endnum,ii;
-    char *seq,*onedata,onedata1[RM],onedata2[RM],FR;
+    u1_t *codes;
     int cc1,canidatenum,loc_seed;
     int num1,num2,BC;
     int low,high,mid,seedcount;
     candidate_save canidate_loc[MAXC],canidate_temp;
-    seq=REFSEQ;
-    j=seqcount/ZV+5;
+    // the read, its reverse complement and their base codes for the alignment
+    vector<u1_t> fwd_codes,rev_codes;
+    vector<char> fwd_read,rev_read;
+    // the sampled k-mers of a strand
+    vector<int> mvalue;
 	
-	int* fwd_index_list = (int*)malloc(sizeof(int) * j);
-	short* fwd_index_score = (short*)malloc(sizeof(short) * j);
-	Back_List* fwd_database = (Back_List*)malloc(sizeof(Back_List) * j);
-	int* rev_index_list = (int*)malloc(sizeof(int) * j);
-	short* rev_index_score = (short*)malloc(sizeof(short) * j);
-	Back_List* rev_database = (Back_List*)malloc(sizeof(Back_List) * j);
-	for (i = 0; i < j; ++i) {
-		fwd_database[i].score = 0;
-		fwd_database[i].score2 = 0;
-		fwd_database[i].index = -1;
-		rev_database[i].score = 0;
-		rev_database[i].score2 = 0;
-		rev_database[i].index = -1;
-	}
-	int fnblk, rnblk;
-	int* pnblk;
+	// the blocks hit by the seeds of either strand and the votes for each of them
+	SeedBlockTable fwd_database, rev_database;
+	vector<short> fwd_index_score, rev_index_score;
 	AlignInfo alns[MAXC + 6];
 	int naln;
 	TempResult results[MAXC + 6];
 	int nresults;
-	long aln_bytes = 1;
-	aln_bytes = aln_bytes * 2 * (MAXC + 6) * MAX_SEQ_SIZE;
-	char* aln_seqs = new char[aln_bytes];
-	u_k = 0;
-	for (int i = 0; i < MAXC + 6; ++i) {
-		results[i].qmap = aln_seqs + u_k;
-		u_k += MAX_SEQ_SIZE;
-		results[i].smap = aln_seqs + u_k;
-		u_k += MAX_SEQ_SIZE;
-	}
+	StringArena aln_strings;
 	
-	vector<char> qstr;
 	vector<char> tstr;
 	GapAligner* aligner = NULL;
 	if (TECH == TECH_PACBIO) {
@@ -334,98 +285,57 @@ static void reference_mapping(int threadint)
 		ERROR("TECH must be either %d or %d", TECH_PACBIO, TECH_NANOPORE);
 	}
 
-    fileid=1;
-    while(fileid)
+    while((batch=take_chunk(&localnum))!=NULL)
     {
-        pthread_mutex_lock(&mutilock);
-        localnum=runnumber;
-        runnumber++;
-        pthread_mutex_unlock(&mutilock);
-        if(localnum>=terminalnum)
-        {
-            fileid=0;
-            break;
-        }
-        if(localnum==terminalnum-1)read_end=readcount;
-        else read_end=(localnum+1)*PLL;
+        chunk_timer.go();
+        readinfo=batch->reads->reads.data();
+        read_end=min((localnum+1)*PLL,(int)batch->reads->reads.size());
         for(read_i=localnum*PLL; read_i<read_end; read_i++)
         {
             read_name=readinfo[read_i].readno;
             read_len=readinfo[read_i].readlen;
-            strcpy(onedata1,readinfo[read_i].seqloc);
+            if((int)fwd_codes.size()<read_len)
+            {
+                fwd_codes.resize(read_len);
+                rev_codes.resize(read_len);
+                fwd_read.resize(read_len);
+                rev_read.resize(read_len);
+                mvalue.resize(read_len+1);
+            }
+            encode_read(readinfo[read_i].seqloc,read_len,fwd_codes.data(),rev_codes.data());
+            alignment_codes(fwd_codes.data(),read_len,fwd_read.data());
+            alignment_codes(rev_codes.data(),read_len,rev_read.data());
 
             canidatenum=0;
             for(ii=1; ii<=2; ii++)
             {
-                read_len=strlen(onedata1);
                 BC=5+(read_len/1000);
                 if(BC>20)BC=20;
                 if(ii==1) {
-					onedata=onedata1;
-					index_list = fwd_index_list;
-					index_score = fwd_index_score;
-					database = fwd_database;
-					pnblk = &fnblk;
+					codes=fwd_codes.data();
+					index_score = &fwd_index_score;
+					database = &fwd_database;
 				} else if(ii==2){
-					index_list = rev_index_list;
-					index_score = rev_index_score;
-					database = rev_database;
-					pnblk = &rnblk;
-                    strcpy(onedata2,onedata1);
-                    onedata=onedata2;
-                    for(j=read_len-1,i=0; j>i; j--,i++)
-                    {
-                        FR=onedata[i];
-                        onedata[i]=onedata[j];
-                        onedata[j]=FR;
-                    }
-                    for(i=0; i<read_len; i++)
-                    {
-                        FR=onedata[i];
-                        switch(FR)
-                        {
-                        case 'A':
-                        {
-                            onedata[i]='T';
-                            break;
-                        }
-                        case 'T':
-                        {
-                            onedata[i]='A';
-                            break;
-                        }
-                        case 'C':
-                        {
-                            onedata[i]='G';
-                            break;
-                        }
-                        case 'G':
-                        {
-                            onedata[i]='C';
-                            break;
-                        }
-                        }
-                    }
+					codes=rev_codes.data();
+					index_score = &rev_index_score;
+					database = &rev_database;
                 }
-                endnum=0;
-                read_len=strlen(onedata);
-                cleave_num=transnum_buchang(onedata,mvalue,&endnum,read_len,seed_len,BC);
+                cleave_num=sample_kmers(codes,read_len,seed_len,BC,mvalue.data());
                 j=0;
-                index_spr=index_list;
-                index_ss=index_score;
                 endnum=0;
                 for(k=0; k<cleave_num; k++)if(mvalue[k]>=0)
                     {
-                        count1=countin[mvalue[k]];
+                        kmer_start=mr_index_kmer_begin(ref_index,mvalue[k]);
+                        count1=mr_index_kmer_begin(ref_index,mvalue[k]+1)-kmer_start;
                         //if(count1>20)continue;
-                        leadarray=databaseindex[mvalue[k]];
-                        for(i=0; i<count1; i++,leadarray++)
+                        for(i=0; i<count1; i++)
                         {
-                            templong=(*leadarray)/ZV;
-                            u_k=(*leadarray)%ZV;
+                            kmer_loc=mr_index_position(ref_index,kmer_start+i);
+                            templong=kmer_loc/ZV;
+                            u_k=kmer_loc%ZV;
                             if(templong>=0)
                             {
-                                temp_spr=database+templong;
+                                temp_spr=database->insert(templong);
                                 if(temp_spr->score==0||temp_spr->seednum<k+1)
                                 {
                                     loc=++(temp_spr->score);
@@ -435,36 +345,35 @@ static void reference_mapping(int threadint)
                                         temp_spr->seedno[loc-1]=k+1;
                                     }
                                     else insert_loc(temp_spr,u_k,k+1,BC);
-                                    if(templong>0)s_k=temp_spr->score+(temp_spr-1)->score;
+                                    if(templong>0)s_k=temp_spr->score+database->get(templong-1)->score;
                                     else s_k=temp_spr->score;
                                     if(endnum<s_k)endnum=s_k;
                                     if(temp_spr->index==-1)
                                     {
-                                        *(index_spr++)=templong;
-                                        *(index_ss++)=s_k;
+                                        index_score->push_back(s_k);
                                         temp_spr->index=j;
                                         j++;
-                                    } else index_score[temp_spr->index]=s_k;
+                                    } else (*index_score)[temp_spr->index]=s_k;
 									temp_spr->score2 = temp_spr->score;
                                 }
                                 temp_spr->seednum=k+1;
                             }
                         }
                     }
-				*pnblk = j;
                 cc1=j;
-                for(i=0,index_spr=index_list,index_ss=index_score; i<cc1; i++,index_spr++,index_ss++)if(*index_ss>6)
+                for(i=0; i<cc1; i++)if((*index_score)[i]>6)
                     {
-                        temp_spr=database+*index_spr;
+                        bid=database->block_id(i);
+                        temp_spr=database->block(i);
                         if(temp_spr->score==0)continue;
                         s_k=temp_spr->score;
-                        if(*index_spr>0)loc=(temp_spr-1)->score;
+                        if(bid>0)loc=database->get(bid-1)->score;
                         else loc=0;
-                        start_loc=(*index_spr)*ZVL;
-                        if(*index_spr>0)
+                        start_loc=bid*ZVL;
+                        if(bid>0)
                         {
-                            loc=(temp_spr-1)->score;
-                            if(loc>0)start_loc=(*index_spr-1)*ZVL;
+                            loc=database->get(bid-1)->score;
+                            if(loc>0)start_loc=(bid-1)*ZVL;
                         }
                         else loc=0;
                         if(loc==0)for(j=0,u_k=0; j<s_k&&j<SM; j++)
@@ -477,7 +386,7 @@ static void reference_mapping(int threadint)
                         {
                             k=loc;
                             u_k=0;
-                            temp_spr1=temp_spr-1;
+                            temp_spr1=database->get(bid-1);
                             for(j=0; j<k&&j<SM; j++)
                             {
                                 temp_list[u_k]=temp_spr1->loczhi[j];
@@ -518,7 +427,7 @@ static void reference_mapping(int threadint)
                         canidate_temp.right1=right_length1;
                         canidate_temp.right2=right_length2;
                         //find all left seed
-                        for(u_k=*index_spr-2,k=num1/ZV,temp_spr1=temp_spr-2; u_k>=0&&k>=0; temp_spr1--,k--,u_k--)if(temp_spr1->score>0)
+                        for(u_k=bid-2,k=num1/ZV; u_k>=0&&k>=0; k--,u_k--)if((temp_spr1=database->get(u_k))->score>0)
                             {
                                 start_loc=u_k*ZVL;
 								int scnt = min((int)temp_spr1->score, SM);
@@ -530,7 +439,7 @@ static void reference_mapping(int threadint)
                                 if(s_k*1.0/scnt>0.4)temp_spr1->score=0;
                             }
                         //find all right seed
-                        for(u_k=*index_spr+1,k=num2/ZV,temp_spr1=temp_spr+1; k>0; temp_spr1++,k--,u_k++)if(temp_spr1->score>0)
+                        for(u_k=bid+1,k=num2/ZV; k>0; k--,u_k++)if((temp_spr1=database->get(u_k))->score>0)
                             {
                                 start_loc=u_k*ZVL;
 								int scnt = min((int)temp_spr1->score, SM);
@@ -567,12 +476,12 @@ static void reference_mapping(int threadint)
             {
 				extend_candidate(canidate_loc[i], 
 								 aligner, 
-								 seq, 
+								 ref_index, 
 								 seqcount,
-								 onedata1, 
-								 onedata2, 
-								 qstr, 
+								 fwd_read.data(), 
+								 rev_read.data(), 
 								 tstr, 
+								 &aln_strings, 
 								 read_name, 
 								 read_len, 
 								 alns, 
@@ -586,109 +495,59 @@ static void reference_mapping(int threadint)
 								  results,
 								  nresults,
 								  aligner, 
-								  seq, 
+								  ref_index, 
 								  seqcount,
-								  onedata1, 
-								  onedata2, 
-								  qstr, 
+								  fwd_read.data(), 
+								  rev_read.data(), 
 								  tstr, 
+								  &aln_strings, 
 								  read_name, 
 								  read_len, 
 								  ZV, 
 								  BC, 
-								  fwd_database, 
-								  rev_database,
+								  &fwd_database, 
+								  &rev_database,
 								  ddfs_cutoff);
 			
 			output_results(alns, naln, results, nresults, num_output, outfile[threadint]);
 			
-			for (int t = 0; t < fnblk; ++t) {
-				int bid = fwd_index_list[t];
-				fwd_database[bid].score = 0;
-				fwd_database[bid].score2 = 0;
-				fwd_database[bid].index = -1;
-			}
-			for (int t = 0; t < rnblk; ++t) {
-				int bid = rev_index_list[t];
-				rev_database[bid].score = 0;
-				rev_database[bid].score2 = 0;
-				rev_database[bid].index = -1;
-			}
+			fwd_database.clear();
+			rev_database.clear();
+			fwd_index_score.clear();
+			rev_index_score.clear();
+			aln_strings.clear();
 
 			if (naln == 0)
             {
                 canidatenum=0;
                 for(ii=1; ii<=2; ii++)
                 {
-                    read_len=strlen(onedata1);
                     BC=5;
                     if(ii==1) {
-						onedata=onedata1;
-						index_list = fwd_index_list;
-						index_score = fwd_index_score;
-						database = fwd_database;
-						pnblk = &fnblk;
+						codes=fwd_codes.data();
+						index_score = &fwd_index_score;
+						database = &fwd_database;
 					} else if(ii==2) {
-						index_list = rev_index_list;
-						index_score = rev_index_score;
-						database = rev_database;
-						pnblk = &rnblk;
-                        strcpy(onedata2,onedata1);
-                        onedata=onedata2;
-                        for(j=read_len-1,i=0; j>i; j--,i++)
-                        {
-                            FR=onedata[i];
-                            onedata[i]=onedata[j];
-                            onedata[j]=FR;
-                        }
-                        for(i=0; i<read_len; i++)
-                        {
-                            FR=onedata[i];
-                            switch(FR)
-                            {
-                            case 'A':
-                            {
-                                onedata[i]='T';
-                                break;
-                            }
-                            case 'T':
-                            {
-                                onedata[i]='A';
-                                break;
-                            }
-                            case 'C':
-                            {
-                                onedata[i]='G';
-                                break;
-                            }
-                            case 'G':
-                            {
-                                onedata[i]='C';
-                                break;
-                            }
-                            }
-                        }
+						codes=rev_codes.data();
+						index_score = &rev_index_score;
+						database = &rev_database;
                     }
-
-                    endnum=0;
-                    read_len=strlen(onedata);
-                    cleave_num=transnum_buchang(onedata,mvalue,&endnum,read_len,seed_len,BC);
+                    cleave_num=sample_kmers(codes,read_len,seed_len,BC,mvalue.data());
                     j=0;
-                    index_spr=index_list;
-                    index_ss=index_score;
                     endnum=0;
                     for(k=0; k<cleave_num; k++)if(mvalue[k]>=0)
                         {
-                            count1=countin[mvalue[k]];
+                            kmer_start=mr_index_kmer_begin(ref_index,mvalue[k]);
+                            count1=mr_index_kmer_begin(ref_index,mvalue[k]+1)-kmer_start;
                             //if(count1>20)continue;
-                            leadarray=databaseindex[mvalue[k]];
-                            for(i=0; i<count1; i++,leadarray++)
+                            for(i=0; i<count1; i++)
                             {
-                                templong=(*leadarray)/ZVS;
-                                u_k=(*leadarray)%ZVS;
+                                kmer_loc=mr_index_position(ref_index,kmer_start+i);
+                                templong=kmer_loc/ZVS;
+                                u_k=kmer_loc%ZVS;
                                 if(templong>=0)
                                 {
-                                    temp_spr=database+templong;
+                                    temp_spr=database->insert(templong);
                                     if(temp_spr->score==0||temp_spr->seednum<k+1)
                                     {
                                         loc=++(temp_spr->score);
@@ -698,36 +557,35 @@ static void reference_mapping(int threadint)
                                             temp_spr->seedno[loc-1]=k+1;
                                         }
                                         else insert_loc(temp_spr,u_k,k+1,BC);
-                                        if(templong>0)s_k=temp_spr->score+(temp_spr-1)->score;
+                                        if(templong>0)s_k=temp_spr->score+database->get(templong-1)->score;
                                         else s_k=temp_spr->score;
                                         if(endnum<s_k)endnum=s_k;
                                         if(temp_spr->index==-1)
                                         {
-                                            *(index_spr++)=templong;
-                                            *(index_ss++)=s_k;
+                                            index_score->push_back(s_k);
                                             temp_spr->index=j;
                                             j++;
-                                        } else index_score[temp_spr->index]=s_k;
+                                        } else (*index_score)[temp_spr->index]=s_k;
 										temp_spr->score2 = temp_spr->score;
                                     }
                                     temp_spr->seednum=k+1;
                                 }
                             }
                         }
-					*pnblk = j;
                     cc1=j;
-                    for(i=0,index_spr=index_list,index_ss=index_score; i<cc1; i++,index_spr++,index_ss++)if(*index_ss>4)
+                    for(i=0; i<cc1; i++)if((*index_score)[i]>4)
                         {
-                            temp_spr=database+*index_spr;
+                            bid=database->block_id(i);
+                            temp_spr=database->block(i);
                             if(temp_spr->score==0)continue;
                             s_k=temp_spr->score;
-                            if(*index_spr>0)loc=(temp_spr-1)->score;
+                            if(bid>0)loc=database->get(bid-1)->score;
                             else loc=0;
-                            start_loc=(*index_spr)*ZVSL;
-                            if(*index_spr>0)
+                            start_loc=bid*ZVSL;
+                            if(bid>0)
                             {
-                                loc=(temp_spr-1)->score;
-                                if(loc>0)start_loc=(*index_spr-1)*ZVSL;
+                                loc=database->get(bid-1)->score;
+                                if(loc>0)start_loc=(bid-1)*ZVSL;
                             }
                             else loc=0;
                             if(loc==0)for(j=0,u_k=0; j<s_k&&j<SM; j++)
@@ -740,7 +598,7 @@ static void reference_mapping(int threadint)
                             {
                                 k=loc;
                                 u_k=0;
-                                temp_spr1=temp_spr-1;
+                                temp_spr1=database->get(bid-1);
                                 for(j=0; j<k&&j<SM; j++)
                                 {
                                     temp_list[u_k]=temp_spr1->loczhi[j];
@@ -781,7 +639,7 @@ static void reference_mapping(int threadint)
                             canidate_temp.right1=right_length1;
                             canidate_temp.right2=right_length2;
                             //find all left seed
-                            for(u_k=*index_spr-2,k=num1/ZVS,temp_spr1=temp_spr-2; u_k>=0&&k>=0; temp_spr1--,k--,u_k--)if(temp_spr1->score>0)
+                            for(u_k=bid-2,k=num1/ZVS; u_k>=0&&k>=0; k--,u_k--)if((temp_spr1=database->get(u_k))->score>0)
                                 {
                                     start_loc=u_k*ZVSL;
 									int scnt = min((int)temp_spr1->score, SM);
@@ -793,7 +651,7 @@ static void reference_mapping(int threadint)
                                     if(s_k*1.0/scnt>0.4)temp_spr1->score=0;
                                 }
                             //find all right seed
-                            for(u_k=*index_spr+1,k=num2/ZVS,temp_spr1=temp_spr+1; k>0; temp_spr1++,k--,u_k++)if(temp_spr1->score>0)
+                            for(u_k=bid+1,k=num2/ZVS; k>0; k--,u_k++)if((temp_spr1=database->get(u_k))->score>0)
                                 {
                                     start_loc=u_k*ZVSL;
 									int scnt = min((int)temp_spr1->score, SM);
@@ -830,12 +688,12 @@ static void reference_mapping(int threadint)
                 {
 					extend_candidate(canidate_loc[i], 
 									 aligner, 
-									 seq, 
+									 ref_index, 
 									 seqcount,
-									 onedata1, 
-									 onedata2, 
-									 qstr, 
+									 fwd_read.data(), 
+									 rev_read.data(), 
 									 tstr, 
+									 &aln_strings, 
 									 read_name, 
 									 read_len, 
 									 alns, 
@@ -849,45 +707,33 @@ static void reference_mapping(int threadint)
 									  results,
 									  nresults,
 									  aligner, 
-									  seq, 
+									  ref_index, 
 									  seqcount,
-									  onedata1, 
-									  onedata2, 
-									  qstr, 
+									  fwd_read.data(), 
+									  rev_read.data(), 
 									  tstr, 
+									  &aln_strings, 
 									  read_name, 
 									  read_len, 
 									  ZVS, 
 									  BC, 
-									  fwd_database, 
-									  rev_database,
+									  &fwd_database, 
+									  &rev_database,
 									  ddfs_cutoff);
 				
 				output_results(alns, naln, results, nresults, num_output, outfile[threadint]);
 				
-				for (int t = 0; t < fnblk; ++t) {
-					int bid = fwd_index_list[t];
-					fwd_database[bid].score = 0;
-					fwd_database[bid].score2 = 0;
-					fwd_database[bid].index = -1;
-				}
-				for (int t = 0; t < rnblk; ++t) {
-					int bid = rev_index_list[t];
-					rev_database[bid].score = 0;
-					rev_database[bid].score2 = 0;
-					rev_database[bid].index = -1;
-				}
+				fwd_database.clear();
+				rev_database.clear();
+				fwd_index_score.clear();
+				rev_index_score.clear();
+				aln_strings.clear();
             }
         }
+        chunk_timer.stop();
+        finish_chunk(batch,chunk_timer.elapsed());
     }
 	delete aligner;
-    free(fwd_database);
-    free(fwd_index_list);
-    free(fwd_index_score);
-	free(rev_database);
-    free(rev_index_list);
-    free(rev_index_score);
-	delete[] aln_seqs;
 }
 
 
@@ -902,65 +748,55 @@ static void* multithread(void* arg)
 	return NULL;
 }
 
-static int load_fastq(FILE *fq)
+// -r is either an index built by 'mecat2ref index' or a FASTA file, whose
+// index is used if it has one next to it that is up to date, or built otherwise
+static void open_ref_index(const char *fastafile)
 {
-    int readlen,readno,sum=0,flag;
-    char *pre;
-    readcount=0;
-    pre=savework;
-    while((flag=fscanf(fq,"%d\t%d\t%s\n",&readno,&readlen,pre))!=EOF&&readcount<SVM&&sum<MAXSTR)
-    {
-        readinfo[readcount].seqloc=pre;
-        readinfo[readcount].readno=readno;
-        readlen=strlen(pre);
-        readinfo[readcount].readlen=readlen;
-        sum=sum+readlen+1;
-        pre=pre+readlen+1;
-        readcount++;
-    }
-    if(flag!=EOF)
+    char path[2048];
+    ref_index=load_mr_index(fastafile);
+    if(!ref_index)
     {
-        readinfo[readcount].seqloc=pre;
-        readinfo[readcount].readno=readno;
-        readlen=strlen(pre);
-        readinfo[readcount].readlen=readlen;
-        readcount++;
-        return(1);
+        generate_mr_index_file_name(fastafile,path);
+        ref_index=load_mr_index(path);
+        if(ref_index&&!mr_index_matches_fasta(ref_index,fastafile))
+        {
+            LOG(stderr, "index '%s' is not built from '%s' as it is now, ignore it.", path, fastafile);
+            ref_index=destroy_mr_index(ref_index);
+        }
+        if(ref_index)LOG(stderr, "use reference index '%s'", path);
     }
-    else return(0);
-}
+    if(!ref_index)ref_index=create_mr_index(fastafile,seed_len);
+    if(ref_index->header->kmer_size!=seed_len)ERROR("the reference index is built with k = %d, %d is expected", ref_index->header->kmer_size, seed_len);
 
+    sprintf(path,"%s/chrindex.txt",workpath);
+    dump_mr_index_chromosomes(ref_index,path);
+    seqcount=ref_index->header->ref_size;
+    printf("%ld\n",seqcount);
+}
 
-int meap_ref_impl_large(int maxc, int noutput, int tech)
+// maps the reads to the reference and returns the number of reads, the timings go to run_log
+int meap_ref_impl_large(const char *wrkdir, const char *fastafile, const char *readsfile, int corenum, int maxc, int noutput, int tech, FILE *logfile)
 {
 	MAXC = maxc;
 	TECH = tech;
 	num_output = noutput;
-    char tempstr[300],fastafile[300];
-    int corenum,readall;
-    int fileflag,threadno,threadflag;
-    FILE *fp,*fastq;
+    char tempstr[300];
+    int threadno,threadflag,readall=0;
     struct timeval tpstart, tpend;
     float timeuse;
-    fp=fopen("config.txt","r");
-    assert(fscanf(fp,"%s\n%s\n%s\n%s\n%d %d\n",workpath,fastafile,fastqfile,tempstr,&corenum,&readall) == 6);
-    fclose(fp);
+    workpath=wrkdir;
     threadnum=corenum;
     //building reference index
     gettimeofday(&tpstart, NULL);
-    seed_len=13;
-    creat_ref_index(fastafile);
+    seed_len=MR_INDEX_KMER_SIZE;
+    open_ref_index(fastafile);
     gettimeofday(&tpend, NULL);
     timeuse = 1000000 * (tpend.tv_sec - tpstart.tv_sec) + tpend.tv_usec - tpstart.tv_usec;
     timeuse /= 1000000;
-    fp = fopen("config.txt", "a");
-    fprintf(fp, "The Building Reference Index Time: %f sec\n", timeuse);
-    fclose(fp);
+    fprintf(logfile, "The Building Reference Index Time: %f sec\n", timeuse);
 
     gettimeofday(&tpstart, NULL);
 
-    savework=(char *)malloc((MAXSTR+RM)*sizeof(char));
-    readinfo=(ReadFasta*)malloc((SVM+2)*sizeof(ReadFasta));
     thread=(pthread_t*)malloc(threadnum*sizeof(pthread_t));
     outfile=(FILE **)malloc(threadnum*sizeof(FILE *));
     for(threadno=0; threadno<threadnum; threadno++)
@@ -968,58 +804,44 @@ int meap_ref_impl_large(int maxc, int noutput, int tech)
         sprintf(tempstr,"%s/%d.r",workpath,threadno+1);
         outfile[threadno]=fopen(tempstr,"w");
     }
-    sprintf(tempstr,"%s/0.fq",workpath);
-    fastq=fopen(tempstr,"r");
-    //multi process thread
-    fileflag=1;
-    while(fileflag)
+    //the reads are parsed in the background, one batch ahead of the mapping
+    ReadBatchReader reads(readsfile,1);
+    read_stream=&reads;
+    run_log=logfile;
+    curr_batch=NULL;
+    num_batches=0;
+    total_busy_time=0.0;
+    reads_done=false;
+    runthreadnum=0;
+    pthread_mutex_init(&mutilock,NULL);
+    pthread_mutex_init(&chunk_lock,NULL);
+    pthread_mutex_init(&batch_lock,NULL);
+    //the workers take chunks of reads until all batches are mapped
+    for(threadno=0; threadno<threadnum; threadno++)
     {
-        fileflag=load_fastq(fastq);
-        if(readcount%PLL==0)terminalnum=readcount/PLL;
-        else terminalnum=readcount/PLL+1;
-        if(readcount<=0)break;
-        runnumber=0;
-        runthreadnum=0;
-
-
-        pthread_mutex_init(&mutilock,NULL);
-        //creat thread
-        if(readcount>0)
+        threadflag= pthread_create(&thread[threadno], NULL, multithread, NULL);
+        if(threadflag)
         {
-            for(threadno=0; threadno<threadnum; threadno++)
-            {
-                threadflag= pthread_create(&thread[threadno], NULL, multithread, NULL);
-                if(threadflag)
-                {
-                    printf("ERROR; return code is %d\n", threadflag);
-                    return EXIT_FAILURE;
-                }
-            }
-            //waiting thread
-            for(threadno=0; threadno<threadnum; threadno++)pthread_join(thread[threadno],NULL);
-
+            printf("ERROR; return code is %d\n", threadflag);
+            return EXIT_FAILURE;
         }
-
-        // reference_mapping(1);
     }
-    fclose(fastq);
+    for(threadno=0; threadno<threadnum; threadno++)pthread_join(thread[threadno],NULL);
+    pthread_mutex_destroy(&chunk_lock);
+    pthread_mutex_destroy(&batch_lock);
+    readall=reads.num_reads();
     //clear creat index memory
-    free(countin);
-    free(databaseindex);
-    free(allloc);
-    free(REFSEQ);
+    ref_index=destroy_mr_index(ref_index);
 
     gettimeofday(&tpend, NULL);
     timeuse = 1000000 * (tpend.tv_sec - tpstart.tv_sec) + tpend.tv_usec - tpstart.tv_usec;
     timeuse /= 1000000;
-    fp = fopen("config.txt", "a");
-    fprintf(fp, "The Mapping Time: %f sec\n", timeuse);
-    fclose(fp);
+    fprintf(logfile, "The Mapping Time: %f sec\n", timeuse);
+    fprintf(logfile, "The Mapping Utilization: %.1f%% of %d threads in %d batches\n",
+            timeuse>0?100.0*total_busy_time/(timeuse*threadnum):100.0, threadnum, num_batches);
 
     for(threadno=0; threadno<threadnum; threadno++)fclose(outfile[threadno]);
     free(outfile);
-    free(savework);
-    free(readinfo);
     free(thread);
-    return 0;
+    return readall;
 }
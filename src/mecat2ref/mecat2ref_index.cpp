@@ -0,0 +1,387 @@
+#include "mecat2ref_index.h"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "../common/split_database.h"
+
+using namespace std;
+
+#define MR_INDEX_MAGIC "MECATRX"
+#define MR_INDEX_VERSION 2
+
+// the FASTA file is read this many bytes at a time
+#define MR_INDEX_READ_BUFFER_SIZE (1 << 22)
+
+static inline size_t
+align8(const size_t n)
+{
+	return (n + 7) & ~(size_t)7;
+}
+
+static inline int
+packed_base(const u1_t* ref, const int64_t i)
+{
+	return (ref[i >> 2] >> ((i & 3) << 1)) & 3;
+}
+
+static inline u1_t
+base_code(const char c)
+{
+	switch (c)
+	{
+		case 'A': return 0;
+		case 'C': return 1;
+		case 'G': return 2;
+		case 'T': return 3;
+		default: return 4;
+	}
+}
+
+// points the sections of idx into its memory image, returns the size of the image
+static size_t
+set_mr_index_sections(mr_index_t* idx)
+{
+	const mr_index_header_t* h = (const mr_index_header_t*)idx->addr;
+	const size_t index_count = (size_t)1 << (2 * h->kmer_size);
+	char* p = (char*)idx->addr;
+	idx->header = h;
+	p += align8(sizeof(mr_index_header_t));
+	idx->chr_idx = (const fastaindexinfo*)p;
+	p += align8(sizeof(fastaindexinfo) * h->num_chr);
+	idx->ref = (const u1_t*)p;
+	p += align8((h->ref_size + 3) / 4);
+	idx->ambig = (const mr_ambig_run_t*)p;
+	p += align8(sizeof(mr_ambig_run_t) * h->num_ambig);
+	idx->kmer_offsets = p;
+	p += align8((h->wide_offsets ? sizeof(uint64_t) : sizeof(uint32_t)) * (index_count + 1));
+	idx->positions = (const u1_t*)p;
+	p += align8(h->pos_bytes * h->num_positions);
+	return p - (char*)idx->addr;
+}
+
+// calls f(kmer, 1-based position) for every k-mer of the reference that has no base other than ACGT
+template <typename F>
+static void
+for_each_kmer(const u1_t* ref, const int64_t ref_size, const vector<mr_ambig_run_t>& ambig, const int kmer_size, F& f)
+{
+	const uint32_t mask = ((uint32_t)1 << (2 * kmer_size)) - 1;
+	int64_t from = 0;
+	for (size_t r = 0; r <= ambig.size(); ++r)
+	{
+		const int64_t to = r < ambig.size() ? ambig[r].start : ref_size;
+		uint32_t kmer = 0;
+		for (int64_t i = from; i < to; ++i)
+		{
+			kmer = ((kmer << 2) | packed_base(ref, i)) & mask;
+			if (i - from + 1 >= kmer_size) f(kmer, i + 2 - kmer_size);
+		}
+		if (r < ambig.size()) from = ambig[r].start + ambig[r].length;
+	}
+}
+
+struct count_kmer
+{
+	uint32_t* counts;
+	void operator()(const uint32_t kmer, const int64_t) { if (counts[kmer] <= MR_INDEX_MAX_KMER_COUNT) ++counts[kmer]; }
+};
+
+// counts[] holds the number of positions filled so far, or UINT32_MAX for k-mers that are not indexed
+template <typename T>
+struct fill_kmer
+{
+	const T* offsets;
+	uint32_t* counts;
+	u1_t* positions;
+	int pos_bytes;
+	void operator()(const uint32_t kmer, const int64_t pos)
+	{
+		if (counts[kmer] == UINT32_MAX) return;
+		const int64_t i = offsets[kmer] + counts[kmer]++;
+		if (pos_bytes == 4)
+		{
+			((uint32_t*)positions)[i] = pos;
+		}
+		else
+		{
+			const uint32_t low = pos;
+			memcpy(positions + i * 5, &low, sizeof(uint32_t));
+			positions[i * 5 + 4] = pos >> 32;
+		}
+	}
+};
+
+template <typename T>
+static void
+fill_mr_index(mr_index_t* idx, uint32_t* counts, const vector<mr_ambig_run_t>& ambig)
+{
+	const mr_index_header_t* h = idx->header;
+	const size_t index_count = (size_t)1 << (2 * h->kmer_size);
+	T* offsets = (T*)idx->kmer_offsets;
+	int64_t n = 0;
+	for (size_t i = 0; i != index_count; ++i)
+	{
+		offsets[i] = n;
+		if (counts[i] > MR_INDEX_MAX_KMER_COUNT) counts[i] = UINT32_MAX;
+		else n += counts[i];
+		if (counts[i] != UINT32_MAX) counts[i] = 0;
+	}
+	offsets[index_count] = n;
+	r_assert(n == h->num_positions);
+
+	fill_kmer<T> f;
+	f.offsets = offsets;
+	f.counts = counts;
+	f.positions = (u1_t*)idx->positions;
+	f.pos_bytes = h->pos_bytes;
+	for_each_kmer(idx->ref, h->ref_size, ambig, h->kmer_size, f);
+}
+
+static void
+add_chromosome(vector<fastaindexinfo>& chrs, const string& header, const int64_t start)
+{
+	fastaindexinfo chr;
+	memset(&chr, 0, sizeof(fastaindexinfo));
+	size_t n = header.find_first_of(" \t\r");
+	if (n == string::npos) n = header.size();
+	n = MIN(n, sizeof(chr.chrname) - 1);
+	memcpy(chr.chrname, header.data(), n);
+	chr.chrstart = start;
+	chrs.push_back(chr);
+}
+
+mr_index_t*
+create_mr_index(const char* fasta_path, const int kmer_size)
+{
+	DynamicTimer dtimer(__func__);
+	r_assert(kmer_size > 0 && kmer_size <= 14);
+	struct stat sbuf;
+	if (stat(fasta_path, &sbuf)) ERROR("failed to stat file '%s'", fasta_path);
+	FILE* fasta = fopen(fasta_path, "r");
+	if (!fasta) ERROR("failed to open file '%s'", fasta_path);
+
+	// 1) the bases, packed, the runs of other characters and the chromosomes.
+	// Every character of a sequence line but CR and LF is a base, as in the FASTA parser this replaces.
+	vector<fastaindexinfo> chrs;
+	vector<mr_ambig_run_t> ambig;
+	string header;
+	size_t packed_capacity = (sbuf.st_size + 3) / 4 + 1;
+	u1_t* packed;
+	safe_calloc(packed, u1_t, packed_capacity);
+	int64_t ref_size = 0;
+	bool in_header = false;
+	char* buffer;
+	safe_malloc(buffer, char, MR_INDEX_READ_BUFFER_SIZE);
+	size_t nread;
+	while ((nread = fread(buffer, 1, MR_INDEX_READ_BUFFER_SIZE, fasta)) > 0)
+	{
+		for (size_t i = 0; i < nread; ++i)
+		{
+			char c = buffer[i];
+			if (in_header)
+			{
+				if (c == '\n')
+				{
+					add_chromosome(chrs, header, ref_size);
+					in_header = false;
+				}
+				else
+				{
+					header += c;
+				}
+				continue;
+			}
+			if (c == '>')
+			{
+				header.clear();
+				in_header = true;
+				continue;
+			}
+			if (c == '\n' || c == '\r') continue;
+			if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+			const u1_t code = base_code(c);
+			if (code < 4)
+			{
+				packed[ref_size >> 2] |= code << ((ref_size & 3) << 1);
+			}
+			else if (!ambig.empty() && ambig.back().base == c && ambig.back().start + ambig.back().length == ref_size)
+			{
+				++ambig.back().length;
+			}
+			else
+			{
+				mr_ambig_run_t run;
+				memset(&run, 0, sizeof(mr_ambig_run_t));
+				run.start = ref_size;
+				run.length = 1;
+				run.base = c;
+				ambig.push_back(run);
+			}
+			++ref_size;
+		}
+	}
+	if (in_header) add_chromosome(chrs, header, ref_size);
+	safe_free(buffer);
+	fclose(fasta);
+	for (size_t i = 0; i < chrs.size(); ++i)
+		chrs[i].chrsize = (i + 1 < chrs.size() ? chrs[i + 1].chrstart : ref_size) - chrs[i].chrstart;
+
+	// 2) the k-mer counts
+	const size_t index_count = (size_t)1 << (2 * kmer_size);
+	uint32_t* counts;
+	safe_calloc(counts, uint32_t, index_count);
+	count_kmer cf;
+	cf.counts = counts;
+	for_each_kmer(packed, ref_size, ambig, kmer_size, cf);
+	int64_t num_positions = 0;
+	for (size_t i = 0; i != index_count; ++i)
+		if (counts[i] <= MR_INDEX_MAX_KMER_COUNT) num_positions += counts[i];
+
+	// 3) the memory image
+	mr_index_header_t h;
+	memset(&h, 0, sizeof(mr_index_header_t));
+	strcpy(h.magic, MR_INDEX_MAGIC);
+	h.version = MR_INDEX_VERSION;
+	h.kmer_size = kmer_size;
+	h.pos_bytes = ref_size + 1 > (int64_t)UINT32_MAX ? 5 : 4;
+	h.wide_offsets = num_positions > (int64_t)UINT32_MAX;
+	h.num_chr = chrs.size();
+	h.ref_size = ref_size;
+	h.num_ambig = ambig.size();
+	h.num_positions = num_positions;
+	h.fasta_size = sbuf.st_size;
+	h.fasta_checksum = sample_file_checksum(fasta_path, sbuf.st_size);
+	h.fasta_mtime = sbuf.st_mtime;
+
+	mr_index_t* idx;
+	safe_calloc(idx, mr_index_t, 1);
+	idx->addr = &h;
+	idx->size = set_mr_index_sections(idx);
+	safe_calloc(idx->addr, char, idx->size);
+	memcpy(idx->addr, &h, sizeof(mr_index_header_t));
+	set_mr_index_sections(idx);
+	if (!chrs.empty()) memcpy((void*)idx->chr_idx, &chrs[0], sizeof(fastaindexinfo) * chrs.size());
+	memcpy((void*)idx->ref, packed, (ref_size + 3) / 4);
+	safe_free(packed);
+	if (!ambig.empty()) memcpy((void*)idx->ambig, &ambig[0], sizeof(mr_ambig_run_t) * ambig.size());
+
+	if (h.wide_offsets) fill_mr_index<uint64_t>(idx, counts, ambig);
+	else fill_mr_index<uint32_t>(idx, counts, ambig);
+	safe_free(counts);
+
+	LOG(stderr, "%lld bases in %lld sequences, %lld positions indexed.", (long long)ref_size, (long long)h.num_chr, (long long)num_positions);
+	return idx;
+}
+
+mr_index_t*
+load_mr_index(const char* path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) return NULL;
+	struct stat sbuf;
+	if (fstat(fd, &sbuf) || (size_t)sbuf.st_size < sizeof(mr_index_header_t)) { close(fd); return NULL; }
+	mr_index_header_t h;
+	if (pread(fd, &h, sizeof(mr_index_header_t), 0) != (ssize_t)sizeof(mr_index_header_t) || memcmp(h.magic, MR_INDEX_MAGIC, sizeof(h.magic)))
+	{
+		close(fd);
+		return NULL;
+	}
+	if (h.version != MR_INDEX_VERSION) ERROR("'%s' is a reference index of version %d, version %d is expected, rebuild it with 'mecat2ref index'", path, h.version, MR_INDEX_VERSION);
+
+	mr_index_t* idx;
+	safe_calloc(idx, mr_index_t, 1);
+	idx->addr = &h;
+	const size_t expected_size = set_mr_index_sections(idx);
+	if ((size_t)sbuf.st_size != expected_size) ERROR("'%s' is truncated or corrupted", path);
+	idx->addr = mmap(NULL, expected_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (idx->addr == MAP_FAILED) ERROR("failed to map file '%s'", path);
+	idx->size = expected_size;
+	idx->mapped = 1;
+	set_mr_index_sections(idx);
+	return idx;
+}
+
+void
+dump_mr_index(const mr_index_t* idx, const char* path)
+{
+	DynamicTimer dtimer(__func__);
+	// write to a private name first so that concurrent readers never see a partial index
+	char tmp_name[2048];
+	sprintf(tmp_name, "%s.%d.tmp", path, (int)getpid());
+	FILE* out = fopen(tmp_name, "wb");
+	if (!out) ERROR("failed to open file '%s'", tmp_name);
+	SAFE_WRITE(idx->addr, char, idx->size, out);
+	if (fclose(out)) ERROR("failed to write to '%s'", tmp_name);
+	if (rename(tmp_name, path)) ERROR("failed to rename '%s' to '%s'", tmp_name, path);
+}
+
+mr_index_t*
+destroy_mr_index(mr_index_t* idx)
+{
+	if (idx->mapped) munmap(idx->addr, idx->size);
+	else safe_free(idx->addr);
+	safe_free(idx);
+	return NULL;
+}
+
+bool
+mr_index_matches_fasta(const mr_index_t* idx, const char* fasta_path)
+{
+	struct stat sbuf;
+	if (stat(fasta_path, &sbuf)) return false;
+	// the checksum only samples the file, an edit that keeps the size is caught by the mtime
+	return idx->header->fasta_size == sbuf.st_size
+		   &&
+		   idx->header->fasta_mtime == (int64_t)sbuf.st_mtime
+		   &&
+		   idx->header->fasta_checksum == sample_file_checksum(fasta_path, sbuf.st_size);
+}
+
+void
+generate_mr_index_file_name(const char* fasta_path, char* index_path)
+{
+	strcpy(index_path, fasta_path);
+	strcat(index_path, ".mri");
+}
+
+// the codes of the four bases of every byte of a packed reference, in memory order
+struct packed_byte_codes
+{
+	uint32_t codes[256];
+	packed_byte_codes()
+	{
+		for (int b = 0; b < 256; ++b)
+		{
+			u1_t c[4] = { (u1_t)(b & 3), (u1_t)((b >> 2) & 3), (u1_t)((b >> 4) & 3), (u1_t)(b >> 6) };
+			memcpy(codes + b, c, sizeof(uint32_t));
+		}
+	}
+};
+
+void
+mr_index_extract(const mr_index_t* idx, const int64_t from, const int64_t to, u1_t* s)
+{
+	static const packed_byte_codes table;
+	int64_t i = from;
+	for (; i < to && (i & 3); ++i) *s++ = packed_base(idx->ref, i);
+	for (; i + 4 <= to; i += 4, s += 4) memcpy(s, table.codes + idx->ref[i >> 2], sizeof(uint32_t));
+	for (; i < to; ++i) *s++ = packed_base(idx->ref, i);
+}
+
+void
+dump_mr_index_chromosomes(const mr_index_t* idx, const char* path)
+{
+	FILE* out = fopen(path, "w");
+	if (!out) ERROR("failed to open file '%s'", path);
+	for (int64_t i = 0; i < idx->header->num_chr; ++i)
+		fprintf(out, "%ld\t%s\t%ld\n", idx->chr_idx[i].chrstart, idx->chr_idx[i].chrname, idx->chr_idx[i].chrsize);
+	fprintf(out, "%ld\t%s\n", (long)idx->header->ref_size, "FileEnd");
+	fclose(out);
+}
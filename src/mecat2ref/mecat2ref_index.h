@@ -0,0 +1,113 @@
+#ifndef MECAT2REF_INDEX_H
+#define MECAT2REF_INDEX_H
+
+#include <cstring>
+
+#include "output.h"
+#include "../common/defs.h"
+
+// The reference index of mecat2ref. It is built from the FASTA file on every
+// run, or once by 'mecat2ref index' and then mapped read-only from disk, so
+// that all mapping jobs on a node share a single copy of it.
+//
+// The index file is laid out as the memory image, every section starts at a
+// multiple of 8 bytes:
+// 1) mr_index_header_t
+// 2) the chromosomes, num_chr fastaindexinfo
+// 3) the reference, 2 bits per base (A, C, G, T = 0 - 3), four bases per byte, the first one in the low bits
+// 4) the runs of bases other than ACGT (N and IUPAC codes), num_ambig mr_ambig_run_t
+// 5) the k-mer offsets, 4^kmer_size + 1 uint32_t, or uint64_t if wide_offsets is set
+// 6) the positions of the k-mers, pos_bytes (4, or 5 for references of 4G bases or more) each
+
+typedef struct
+{
+	char magic[8];
+	int version;
+	int kmer_size;
+	int pos_bytes;
+	int wide_offsets;
+	int64_t num_chr;
+	int64_t ref_size;
+	int64_t num_ambig;
+	int64_t num_positions;
+	// size, mtime and sampled checksum of the FASTA file the index is built from
+	int64_t fasta_size;
+	uint64_t fasta_checksum;
+	int64_t fasta_mtime;
+} mr_index_header_t;
+
+typedef struct
+{
+	int64_t start;
+	int64_t length;
+	char base;
+	char pad[7];
+} mr_ambig_run_t;
+
+typedef struct
+{
+	// the memory image, mapped from an index file if mapped is set
+	void* addr;
+	size_t size;
+	int mapped;
+	const mr_index_header_t* header;
+	const fastaindexinfo* chr_idx;
+	const u1_t* ref;
+	const mr_ambig_run_t* ambig;
+	const void* kmer_offsets;
+	const u1_t* positions;
+} mr_index_t;
+
+// the seed length of the mapper
+#define MR_INDEX_KMER_SIZE 13
+// k-mers occurring more often than this are not indexed
+#define MR_INDEX_MAX_KMER_COUNT 128
+
+// the positions of k-mer kmer are [mr_index_kmer_begin(kmer), mr_index_kmer_begin(kmer + 1))
+static inline int64_t
+mr_index_kmer_begin(const mr_index_t* idx, const uint32_t kmer)
+{
+	if (idx->header->wide_offsets) return ((const uint64_t*)idx->kmer_offsets)[kmer];
+	return ((const uint32_t*)idx->kmer_offsets)[kmer];
+}
+
+// the 1-based reference offset of the i-th indexed k-mer
+static inline int64_t
+mr_index_position(const mr_index_t* idx, const int64_t i)
+{
+	if (idx->header->pos_bytes == 4) return ((const uint32_t*)idx->positions)[i];
+	const u1_t* p = idx->positions + i * 5;
+	uint32_t low;
+	memcpy(&low, p, sizeof(uint32_t));
+	return (int64_t)low | ((int64_t)p[4] << 32);
+}
+
+mr_index_t*
+create_mr_index(const char* fasta_path, const int kmer_size);
+
+// returns NULL if path is not a mecat2ref index
+mr_index_t*
+load_mr_index(const char* path);
+
+void
+dump_mr_index(const mr_index_t* idx, const char* path);
+
+mr_index_t*
+destroy_mr_index(mr_index_t* idx);
+
+// whether idx is built from the FASTA file fasta_path as it is now
+bool
+mr_index_matches_fasta(const mr_index_t* idx, const char* fasta_path);
+
+void
+generate_mr_index_file_name(const char* fasta_path, char* index_path);
+
+// writes the codes (0 - 3) of the reference bases [from, to) to s, bases other than ACGT are 0
+void
+mr_index_extract(const mr_index_t* idx, const int64_t from, const int64_t to, u1_t* s);
+
+// writes the chromosomes in the format of chrindex.txt
+void
+dump_mr_index_chromosomes(const mr_index_t* idx, const char* path);
+
+#endif // MECAT2REF_INDEX_H
@@ -0,0 +1,175 @@
+#include "mecat2ref_reads.h"
+
+#include "../common/defs.h"
+
+ReadBatchReader::ReadBatchReader(const char* path, const int max_batches)
+	: buffer_(kBufferSize), buf_pos_(0), buf_len_(0), is_fasta_(true), at_eof_(false),
+	  have_header_(false), next_id_(0), num_reads_(0), max_batches_(max_batches), done_(false), stop_(false)
+{
+	in_ = gzopen(path, "rb");
+	if (!in_) ERROR("failed to open file '%s' for reading", path);
+
+	// the first line is the header of the first read
+	std::vector<char> line;
+	while (get_line(line))
+	{
+		if (line.empty()) continue;
+		is_fasta_ = line[0] == '>';
+		next_id_ = is_fasta_ ? 0 : 1;
+		have_header_ = true;
+		break;
+	}
+
+	pthread_mutex_init(&lock_, NULL);
+	pthread_cond_init(&cond_, NULL);
+	pthread_create(&tid_, NULL, read_func, static_cast<void*>(this));
+}
+
+ReadBatchReader::~ReadBatchReader()
+{
+	pthread_mutex_lock(&lock_);
+	stop_ = true;
+	pthread_cond_broadcast(&cond_);
+	pthread_mutex_unlock(&lock_);
+	pthread_join(tid_, NULL);
+	for (size_t i = 0; i < queue_.size(); ++i) delete queue_[i];
+	pthread_mutex_destroy(&lock_);
+	pthread_cond_destroy(&cond_);
+	gzclose(in_);
+}
+
+ReadBatch*
+ReadBatchReader::next()
+{
+	pthread_mutex_lock(&lock_);
+	while (queue_.empty() && !done_) pthread_cond_wait(&cond_, &lock_);
+	ReadBatch* batch = NULL;
+	if (!queue_.empty())
+	{
+		batch = queue_.front();
+		queue_.erase(queue_.begin());
+		pthread_cond_broadcast(&cond_);
+	}
+	pthread_mutex_unlock(&lock_);
+	return batch;
+}
+
+void*
+ReadBatchReader::read_func(void* arg)
+{
+	ReadBatchReader* reader = static_cast<ReadBatchReader*>(arg);
+	bool more = reader->have_header_;
+	while (more)
+	{
+		// a batch is only started when the queue has room for it
+		pthread_mutex_lock(&reader->lock_);
+		while ((int)reader->queue_.size() >= reader->max_batches_ && !reader->stop_)
+			pthread_cond_wait(&reader->cond_, &reader->lock_);
+		const bool stop = reader->stop_;
+		pthread_mutex_unlock(&reader->lock_);
+		if (stop) break;
+
+		ReadBatch* batch = new ReadBatch;
+		more = reader->fill_batch(batch);
+		pthread_mutex_lock(&reader->lock_);
+		if (batch->reads.empty()) delete batch;
+		else reader->queue_.push_back(batch);
+		pthread_cond_broadcast(&reader->cond_);
+		pthread_mutex_unlock(&reader->lock_);
+	}
+	pthread_mutex_lock(&reader->lock_);
+	reader->done_ = true;
+	pthread_cond_broadcast(&reader->cond_);
+	pthread_mutex_unlock(&reader->lock_);
+	return NULL;
+}
+
+// the next line without its line break, false at the end of the file
+bool
+ReadBatchReader::get_line(std::vector<char>& line)
+{
+	line.clear();
+	while (true)
+	{
+		if (buf_pos_ == buf_len_)
+		{
+			if (at_eof_) return !line.empty();
+			buf_len_ = gzread(in_, buffer_.data(), kBufferSize);
+			buf_pos_ = 0;
+			if (buf_len_ < 0)
+			{
+				int errnum;
+				ERROR("failed to read reads: %s", gzerror(in_, &errnum));
+			}
+			if (buf_len_ == 0)
+			{
+				at_eof_ = true;
+				return !line.empty();
+			}
+		}
+		const char* p = buffer_.data() + buf_pos_;
+		const char* e = static_cast<const char*>(memchr(p, '\n', buf_len_ - buf_pos_));
+		const int n = e ? (int)(e - p) : buf_len_ - buf_pos_;
+		line.insert(line.end(), p, p + n);
+		buf_pos_ += n;
+		if (e)
+		{
+			++buf_pos_;
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			return true;
+		}
+	}
+}
+
+void
+ReadBatchReader::append_bases(ReadBatch* batch, const std::vector<char>& line)
+{
+	for (size_t i = 0; i < line.size(); ++i)
+		if (!isspace((unsigned char)line[i])) batch->bases.push_back(line[i]);
+}
+
+// returns whether there are reads left after the batch
+bool
+ReadBatchReader::fill_batch(ReadBatch* batch)
+{
+	std::vector<char> line;
+	offsets_.clear();
+	batch->bases.reserve(MAXSTR + RM);
+	while (have_header_ && (int)batch->reads.size() < SVM && batch->bases.size() < (size_t)MAXSTR)
+	{
+		ReadFasta read;
+		read.readno = next_id_++;
+		offsets_.push_back(batch->bases.size());
+		have_header_ = false;
+		if (is_fasta_)
+		{
+			while (get_line(line))
+			{
+				if (!line.empty() && line[0] == '>')
+				{
+					have_header_ = true;
+					break;
+				}
+				append_bases(batch, line);
+			}
+		}
+		else
+		{
+			if (!get_line(line)) ERROR("the sequence of FASTQ read %d is missing", read.readno);
+			append_bases(batch, line);
+			if (!get_line(line) || !get_line(line)) ERROR("the quality scores of FASTQ read %d are missing", read.readno);
+			while (get_line(line))
+				if (!line.empty())
+				{
+					have_header_ = true;
+					break;
+				}
+		}
+		read.readlen = batch->bases.size() - offsets_.back();
+		batch->bases.push_back('\0');
+		batch->reads.push_back(read);
+	}
+	for (size_t i = 0; i < batch->reads.size(); ++i) batch->reads[i].seqloc = batch->bases.data() + offsets_[i];
+	num_reads_ += batch->reads.size();
+	return have_header_;
+}
@@ -0,0 +1,62 @@
+#ifndef MECAT2REF_READS_H
+#define MECAT2REF_READS_H
+
+#include <pthread.h>
+#include <zlib.h>
+
+#include <vector>
+
+#include "mecat2ref_defs.h"
+
+// up to SVM reads or MAXSTR bases, each sequence is 0-terminated in bases
+struct ReadBatch
+{
+	std::vector<ReadFasta> reads;
+	std::vector<char> bases;
+};
+
+// Streams the reads of a FASTA or FASTQ file, optionally gzip compressed, in
+// batches. A reader thread parses the next batch while the current one is
+// mapped, the queue between them holds max_batches batches, so that at most
+// max_batches + 1 batches are in memory.
+//
+// Reads are numbered as they always were by mecat2ref: from 0 in FASTA files
+// and from 1 in FASTQ files. FASTQ records must take four lines.
+class ReadBatchReader
+{
+public:
+	ReadBatchReader(const char* path, const int max_batches);
+	~ReadBatchReader();
+	// returns NULL after the last batch, the caller deletes the batch
+	ReadBatch* next();
+	int num_reads() const { return num_reads_; }
+
+private:
+	static void* read_func(void* arg);
+	bool get_line(std::vector<char>& line);
+	bool fill_batch(ReadBatch* batch);
+	void append_bases(ReadBatch* batch, const std::vector<char>& line);
+
+private:
+	static const int kBufferSize = 1 << 20;
+	gzFile in_;
+	std::vector<char> buffer_;
+	int buf_pos_, buf_len_;
+	bool is_fasta_;
+	bool at_eof_;
+	// the header of the next FASTA read, which ends the current one
+	bool have_header_;
+	int next_id_;
+	int num_reads_;
+	std::vector<size_t> offsets_;
+
+	int max_batches_;
+	std::vector<ReadBatch*> queue_;
+	bool done_;
+	bool stop_;
+	pthread_mutex_t lock_;
+	pthread_cond_t cond_;
+	pthread_t tid_;
+};
+
+#endif // MECAT2REF_READS_H
@@ -0,0 +1,119 @@
+// Checks the alignments of BitVectorAligner on random overlaps: the aligned
+// strings must spell the aligned parts of both sequences, and when either
+// side of the seed fits in one block, the alignment of that side must have
+// the minimal edit distance, as computed by a plain dynamic program.
+//
+// usage: bitvec_align_check [trials]
+
+#include "bitvec_gapalign.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void
+mutate(const vector<char>& src, vector<char>& dst, const double err)
+{
+	dst.clear();
+	for (size_t i = 0; i < src.size(); ++i) {
+		const double r = drand48();
+		if (r < err / 3) {
+			dst.push_back(lrand48() & 3);
+		} else if (r < 2 * err / 3) {
+			dst.push_back(src[i]);
+			dst.push_back(lrand48() & 3);
+		} else if (r >= err) {
+			dst.push_back(src[i]);
+		}
+	}
+}
+
+static string
+bases(const vector<char>& s, const int from, const int to)
+{
+	string r;
+	for (int i = from; i < to; ++i) r += "ACGT"[(int)s[i]];
+	return r;
+}
+
+static int
+edit_distance(const string& a, const string& b)
+{
+	vector<int> d(b.size() + 1);
+	for (size_t j = 0; j <= b.size(); ++j) d[j] = j;
+	for (size_t i = 1; i <= a.size(); ++i) {
+		int diag = d[0];
+		d[0] = i;
+		for (size_t j = 1; j <= b.size(); ++j) {
+			const int up = d[j];
+			d[j] = min(min(d[j] + 1, d[j - 1] + 1), diag + (a[i - 1] != b[j - 1]));
+			diag = up;
+		}
+	}
+	return d[b.size()];
+}
+
+static int
+aligned_distance(const char* q, const char* t, const int from, const int to)
+{
+	int dist = 0;
+	for (int k = from; k < to; ++k) dist += q[k] != t[k];
+	return dist;
+}
+
+static string
+ungapped(const char* s, const int from, const int to)
+{
+	string r;
+	for (int k = from; k < to; ++k) if (s[k] != '-') r += s[k];
+	return r;
+}
+
+int main(int argc, char* argv[])
+{
+	const int trials = argc > 1 ? atoi(argv[1]) : 2000;
+	srand48(7);
+	BitVectorAligner aligner(0);
+	vector<char> a, b;
+	int num_errors = 0, num_optimal_checks = 0;
+	for (int t = 0; t < trials; ++t) {
+		// every other overlap fits in one block on both sides of the seed
+		const bool one_block = t % 2 == 0;
+		const int len = one_block ? 40 + lrand48() % 900 : 2000 + lrand48() % 6000;
+		a.resize(len);
+		for (int i = 0; i < len; ++i) a[i] = lrand48() & 3;
+		mutate(a, b, (lrand48() % 30) / 100.0);
+		if (lrand48() % 4 == 0) for (size_t i = b.size() * 3 / 4; i < b.size(); ++i) b[i] = lrand48() & 3;
+		const int qstart = len / 2;
+		const int tstart = min(qstart, (int)b.size() / 2);
+
+		aligner.go(a.data(), qstart, a.size(), b.data(), tstart, b.size(), 0);
+		const OutputStore* r = aligner.result;
+		const char* qaln = aligner.query_mapped_string();
+		const char* taln = aligner.target_mapped_string();
+		const int left = r->left_store_size;
+		string error;
+		if (ungapped(qaln, 0, r->out_store_size) != bases(a, r->query_start, r->query_end)
+			|| ungapped(taln, 0, r->out_store_size) != bases(b, r->target_start, r->target_end)) {
+			error = "the aligned strings do not spell the sequences";
+		} else if (one_block) {
+			num_optimal_checks += 2;
+			const int ld = edit_distance(bases(a, r->query_start, qstart), bases(b, r->target_start, tstart));
+			const int rd = edit_distance(bases(a, qstart, r->query_end), bases(b, tstart, r->target_end));
+			if (aligned_distance(qaln, taln, 0, left) != ld || aligned_distance(qaln, taln, left, r->out_store_size) != rd)
+				error = "the alignment is not minimal";
+		}
+		if (!error.empty()) {
+			if (num_errors < 10)
+				fprintf(stderr, "overlap %d (%d x %d): %s, [%d, %d) x [%d, %d)\n", t, (int)a.size(), (int)b.size(), error.c_str(),
+						r->query_start, r->query_end, r->target_start, r->target_end);
+			++num_errors;
+		}
+	}
+	printf("%d overlaps, %d sides checked for minimal distance, %d errors\n", trials, num_optimal_checks, num_errors);
+	return num_errors != 0;
+}
@@ -0,0 +1,107 @@
+// Checks pac_decode, pac_decode_rc and reverse_complement_codes against
+// PackedDB::get_char on random ranges of 0 to 300 bases with any start, into
+// buffers at any alignment, in place and out of place. The kernel is chosen
+// once per process, so the check runs itself once for every value of
+// MECAT_PAC_KERNEL.
+//
+// usage: pac_decode_check [trials]
+
+#include "packed_db.h"
+#include "pac_decode.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+static const int kMaxLength = 300;
+static const int kGuard = 64;
+static const char kGuardByte = 0x55;
+
+static bool
+guards_intact(const vector<char>& buf, const int offset, const int len)
+{
+	for (int k = 0; k < offset; ++k) if (buf[k] != kGuardByte) return false;
+	for (size_t k = offset + len; k < buf.size(); ++k) if (buf[k] != kGuardByte) return false;
+	return true;
+}
+
+static int
+check_kernel(const int trials)
+{
+	const idx_t num_bases = 4096;
+	vector<u1_t> pac((num_bases + 3) / 4, 0);
+	for (idx_t i = 0; i < num_bases; ++i) PackedDB::set_char(pac.data(), i, lrand48() & 3);
+
+	vector<char> buf(kGuard + kMaxLength + kGuard), src(kMaxLength), expected(kMaxLength);
+	int num_errors = 0;
+	for (int t = 0; t < trials; ++t)
+	{
+		const int len = t % (kMaxLength + 1);
+		const idx_t from = lrand48() % (num_bases - kMaxLength);
+		const idx_t to = from + len;
+		const int offset = 1 + lrand48() % (kGuard - 1);
+		char* seq = buf.data() + offset;
+		const char* error = NULL;
+
+		fill(buf.begin(), buf.end(), kGuardByte);
+		pac_decode(pac.data(), from, to, seq);
+		for (int k = 0; k < len; ++k) expected[k] = PackedDB::get_char(pac.data(), from + k);
+		if (memcmp(seq, expected.data(), len) || !guards_intact(buf, offset, len)) error = "pac_decode";
+
+		fill(buf.begin(), buf.end(), kGuardByte);
+		pac_decode_rc(pac.data(), from, to, seq);
+		for (int k = 0; k < len; ++k) expected[k] = 3 - PackedDB::get_char(pac.data(), to - 1 - k);
+		if (!error && (memcmp(seq, expected.data(), len) || !guards_intact(buf, offset, len))) error = "pac_decode_rc";
+
+		for (int k = 0; k < len; ++k) src[k] = lrand48() & 3;
+		for (int k = 0; k < len; ++k) expected[k] = 3 - src[len - 1 - k];
+		fill(buf.begin(), buf.end(), kGuardByte);
+		reverse_complement_codes(seq, src.data(), len);
+		if (!error && (memcmp(seq, expected.data(), len) || !guards_intact(buf, offset, len))) error = "reverse_complement_codes out of place";
+
+		fill(buf.begin(), buf.end(), kGuardByte);
+		memcpy(seq, src.data(), len);
+		reverse_complement_codes(seq, seq, len);
+		if (!error && (memcmp(seq, expected.data(), len) || !guards_intact(buf, offset, len))) error = "reverse_complement_codes in place";
+
+		if (error)
+		{
+			if (num_errors < 10)
+				fprintf(stderr, "%s kernel: %s of [%lld, %lld) at offset %d is wrong\n", pac_decode_kernel_name(), error, (long long)from, (long long)to, offset);
+			++num_errors;
+		}
+	}
+	printf("%s kernel: %d ranges, %d errors\n", pac_decode_kernel_name(), trials, num_errors);
+	return num_errors;
+}
+
+int main(int argc, char* argv[])
+{
+	const int trials = argc > 1 ? atoi(argv[1]) : 20000;
+	srand48(13);
+	if (getenv("MECAT_PAC_KERNEL")) return check_kernel(trials) != 0;
+
+	// "avx2" is not a limit, the best kernel of the machine is used
+	const char* kernels[] = { "scalar", "ssse3", "avx2" };
+	int failed = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		fflush(stdout);
+		const pid_t pid = fork();
+		if (pid == 0)
+		{
+			setenv("MECAT_PAC_KERNEL", kernels[i], 1);
+			execv("/proc/self/exe", argv);
+			_exit(127);
+		}
+		int status = 0;
+		if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status)) failed = 1;
+	}
+	return failed;
+}
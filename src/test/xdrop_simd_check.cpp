@@ -0,0 +1,129 @@
+// Checks that the SSE2 X-drop kernel gives the same score, end point and edit
+// script as the scalar xdrop_align() on random blocks, and that XdropAligner
+// gives the same alignments with either kernel.
+//
+// usage: xdrop_simd_check [trials]
+
+#include "xdrop_gapalign.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// substitutions, insertions and deletions at rate err / 3 each
+static void
+mutate(const vector<char>& src, vector<char>& dst, const double err)
+{
+	dst.clear();
+	for (size_t i = 0; i < src.size(); ++i) {
+		const double r = drand48();
+		if (r < err / 3) {
+			dst.push_back(lrand48() & 3);
+		} else if (r < 2 * err / 3) {
+			dst.push_back(src[i]);
+			dst.push_back(lrand48() & 3);
+		} else if (r >= err) {
+			dst.push_back(src[i]);
+		}
+	}
+}
+
+static void
+random_pair(const int len, vector<char>& a, vector<char>& b)
+{
+	a.resize(len);
+	for (int i = 0; i < len; ++i) a[i] = lrand48() & 3;
+	mutate(a, b, (lrand48() % 40) / 100.0);
+	// a divergent tail, so that the X-drop stops inside the block
+	if (lrand48() % 4 == 0) for (size_t i = b.size() / 2; i < b.size(); ++i) b[i] = lrand48() & 3;
+}
+
+#if defined(__SSE2__)
+static int
+check_blocks(XdropAligner& x, const int trials)
+{
+	GapPrelimEditBlock simd_block;
+	vector<char> a, b;
+	int num_diffs = 0;
+	for (int t = 0; t < trials; ++t) {
+		const int len = 5 + lrand48() % 1300;
+		random_pair(len + 50, a, b);
+		const int M = len;
+		const int N = min((int)b.size(), 5 + (int)(lrand48() % 1350));
+		const bool forward = lrand48() & 1;
+		const char* A = forward ? a.data() : a.data() + M - 1;
+		const char* B = forward ? b.data() : b.data() + N - 1;
+		int ae1, be1, ae2, be2;
+		const int s1 = xdrop_align(A, M, B, N, x.score_matrix, x.param.gap_open, x.param.gap_extend, x.param.x_dropoff,
+								   x.state_array, x.score_array, x.edit_script, x.edit_start_offset, &x.edit_block, forward, ae1, be1);
+		const int s2 = xdrop_align_sse2(A, M, B, N, x.param.x_dropoff, x.simd_buf,
+										x.state_array, x.edit_script, x.edit_start_offset, &simd_block, forward, ae2, be2);
+		bool same = s1 == s2 && ae1 == ae2 && be1 == be2 && x.edit_block.num_ops == simd_block.num_ops;
+		for (int k = 0; same && k < simd_block.num_ops; ++k)
+			same = x.edit_block.edit_ops[k].op_type == simd_block.edit_ops[k].op_type
+				   && x.edit_block.edit_ops[k].num == simd_block.edit_ops[k].num;
+		if (!same) {
+			if (num_diffs < 10)
+				fprintf(stderr, "block %d (%d x %d, %s): score %d / %d, end (%d, %d) / (%d, %d), %d / %d edit ops\n",
+						t, M, N, forward ? "forward" : "reverse", s1, s2, ae1, be1, ae2, be2, x.edit_block.num_ops, simd_block.num_ops);
+			++num_diffs;
+		}
+	}
+	return num_diffs;
+}
+
+static int
+check_alignments(XdropAligner& simd, XdropAligner& scalar, const int trials)
+{
+	vector<char> a, b;
+	int num_diffs = 0;
+	for (int t = 0; t < trials; ++t) {
+		random_pair(1000 + lrand48() % 4000, a, b);
+		const int qstart = lrand48() % a.size();
+		const int tstart = min(qstart, (int)b.size() - 1);
+		const bool r1 = simd.go(a.data(), qstart, a.size(), b.data(), tstart, b.size(), 0);
+		const bool r2 = scalar.go(a.data(), qstart, a.size(), b.data(), tstart, b.size(), 0);
+		const bool same = r1 == r2
+						  && simd.query_start() == scalar.query_start() && simd.query_end() == scalar.query_end()
+						  && simd.target_start() == scalar.target_start() && simd.target_end() == scalar.target_end()
+						  && simd.aln_size == scalar.aln_size
+						  && string(simd.qaln, simd.aln_size) == string(scalar.qaln, scalar.aln_size)
+						  && string(simd.taln, simd.aln_size) == string(scalar.taln, scalar.aln_size);
+		if (!same) {
+			if (num_diffs < 10)
+				fprintf(stderr, "alignment %d: [%d, %d) x [%d, %d) / [%d, %d) x [%d, %d)\n", t,
+						simd.query_start(), simd.query_end(), simd.target_start(), simd.target_end(),
+						scalar.query_start(), scalar.query_end(), scalar.target_start(), scalar.target_end());
+			++num_diffs;
+		}
+	}
+	return num_diffs;
+}
+#endif // __SSE2__
+
+int main(int argc, char* argv[])
+{
+#if defined(__SSE2__)
+	const int trials = argc > 1 ? atoi(argv[1]) : 5000;
+	srand48(11);
+	XdropAligner simd(0), scalar(0);
+	if (!simd.simd_buf) {
+		fprintf(stderr, "the SSE2 kernel is disabled (MECAT_XDROP_KERNEL=scalar?)\n");
+		return 1;
+	}
+	sfree(scalar.simd_buf);
+	scalar.simd_buf = NULL;
+
+	const int block_diffs = check_blocks(simd, trials);
+	const int aln_diffs = check_alignments(simd, scalar, trials / 10);
+	printf("%d blocks, %d differ; %d alignments, %d differ\n", trials, block_diffs, trials / 10, aln_diffs);
+	return block_diffs || aln_diffs;
+#else
+	printf("no SSE2, nothing to check\n");
+	return 0;
+#endif
+}